@@ -0,0 +1,244 @@
+#ifndef ABALONE_ANALYSIS_POOL_H
+#define ABALONE_ANALYSIS_POOL_H
+
+#include "engine.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// one position to analyse, with its limits; the search ends at whichever limit comes first
+struct AnalysisRequest {
+    AbaloneBoard board;
+    CellState toMove = CellState::BLACK;
+    int depth = 64;
+    int64_t movetimeMs = 0;  // 0: none
+    uint64_t nodes = 0;      // 0: none
+};
+
+// a completed iteration, or the final result of a request
+struct AnalysisInfo {
+    std::string move;  // empty if the side to move has no legal move
+    int score = 0;     // from Black's point of view, like every score of the engine
+    int depth = 0;
+    uint64_t nodes = 0;
+    int64_t timeMs = 0;
+    std::vector<std::string> pv;
+    bool cancelled = false;  // (result only) cancelled before or during its search
+};
+
+// Fixed pool of search workers for many small requests: a request waits in a bounded queue for
+// a free worker, which searches it single-threaded (searchBestMove) while a watchdog enforces its
+// time and node limits. All workers share the transposition table, so requests about related
+// positions help each other, as the search threads of one search do. The table is never cleared
+// while the pool runs: it has a fixed size, and old entries are replaced as new ones come in.
+class AnalysisPool {
+public:
+    // called on the worker thread: after every completed iteration, and exactly once at the end
+    // of every accepted request (also when it is cancelled or the pool shuts down)
+    using InfoCallback = std::function<void(const AnalysisInfo&)>;
+
+    // set to cancel a request; shared so the caller can cancel after handing the request over
+    using CancelFlag = std::shared_ptr<std::atomic<bool>>;
+
+private:
+    struct Job {
+        AnalysisRequest request;
+        InfoCallback onInfo;
+        InfoCallback onDone;
+        CancelFlag cancelled;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::shared_ptr<Job> job;  // guarded by mutex
+        std::chrono::steady_clock::time_point deadline;
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> nodes{0};
+    };
+
+    SearchParams searchParams;
+    size_t maxQueued;
+    std::deque<Worker> workers;  // a deque: workers don't move
+    std::deque<std::shared_ptr<Job>> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool shuttingDown = false;
+    uint64_t completed = 0;
+    std::thread watchdog;
+
+public:
+    // params are the search settings of every request (depth and limits come with the request);
+    // at most maxQueued requests wait
+    AnalysisPool(int workerCount, size_t maxQueued, const SearchParams& params)
+        : searchParams(params), maxQueued(maxQueued) {
+        searchParams.threads = 1;
+        searchParams.stats = nullptr;
+        searchParams.history = nullptr;
+        for (int i = 0; i < std::max(1, workerCount); i++) {
+            workers.emplace_back();
+        }
+        for (Worker& worker : workers) {
+            worker.thread = std::thread([this, &worker]() { work(worker); });
+        }
+        watchdog = std::thread([this]() { watch(); });
+    }
+
+    AnalysisPool(const AnalysisPool&) = delete;
+    AnalysisPool& operator=(const AnalysisPool&) = delete;
+
+    // cancels everything still queued or running
+    ~AnalysisPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shuttingDown = true;
+            for (const auto& job : queue) {
+                *job->cancelled = true;
+            }
+            for (Worker& worker : workers) {
+                worker.stop = true;
+            }
+        }
+        wake.notify_all();
+        for (Worker& worker : workers) {
+            worker.thread.join();
+        }
+        watchdog.join();
+    }
+
+    // queue a request; false if the queue is full (onDone is then never called)
+    bool submit(const AnalysisRequest& request, InfoCallback onInfo, InfoCallback onDone, CancelFlag cancelled) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (shuttingDown || queue.size() >= maxQueued) {
+                return false;
+            }
+            queue.push_back(std::make_shared<Job>(Job{request, std::move(onInfo), std::move(onDone), std::move(cancelled)}));
+        }
+        wake.notify_one();
+        return true;
+    }
+
+    struct Status {
+        int workers = 0;
+        int busy = 0;
+        size_t queued = 0;
+        uint64_t completed = 0;
+    };
+
+    [[nodiscard]] Status status() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Status status;
+        status.workers = static_cast<int>(workers.size());
+        for (const Worker& worker : workers) {
+            status.busy += worker.job ? 1 : 0;
+        }
+        status.queued = queue.size();
+        status.completed = completed;
+        return status;
+    }
+
+private:
+    void work(Worker& worker) {
+        while (true) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this]() { return shuttingDown || !queue.empty(); });
+                if (queue.empty()) {
+                    return;
+                }
+                job = queue.front();
+                queue.pop_front();
+                worker.job = job;
+                worker.stop = shuttingDown || *job->cancelled;
+                worker.nodes = 0;
+                worker.deadline = (job->request.movetimeMs > 0)
+                                      ? std::chrono::steady_clock::now() +
+                                            std::chrono::milliseconds(job->request.movetimeMs)
+                                      : std::chrono::steady_clock::time_point::max();
+            }
+            const AnalysisInfo result = search(worker, *job);
+            job->onDone(result);
+            std::lock_guard<std::mutex> lock(mutex);
+            worker.job.reset();
+            completed++;
+        }
+    }
+
+    AnalysisInfo search(Worker& worker, const Job& job) {
+        const AnalysisRequest& request = job.request;
+        const auto start = std::chrono::steady_clock::now();
+        const auto elapsedMs = [&start]() {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)
+                .count();
+        };
+        MoveList legalMoves;
+        request.board.generateLegalMoves(request.toMove, legalMoves);
+        AnalysisInfo result;
+        if (legalMoves.empty() || worker.stop) {
+            result.cancelled = !legalMoves.empty();
+            return result;
+        }
+
+        SearchParams params = searchParams;
+        params.depth = request.depth;
+        params.stop = &worker.stop;
+        params.nodes = &worker.nodes;
+        params.onIteration = [&](const SearchResult& iteration) {
+            if (job.onInfo) {
+                job.onInfo(info(request, iteration, worker.nodes, elapsedMs()));
+            }
+        };
+        AbaloneBoard board = request.board;
+        const SearchResult best = searchBestMove(board, request.toMove, params);
+        result = info(request, best, worker.nodes, elapsedMs());
+        result.cancelled = *job.cancelled;
+        if (result.move.empty()) {
+            result.move = legalMoves[0].str();  // stopped within the first iteration
+        }
+        return result;
+    }
+
+    static AnalysisInfo info(const AnalysisRequest& request, const SearchResult& searched, uint64_t nodes,
+                             int64_t timeMs) {
+        AnalysisInfo info;
+        info.move = searched.move;
+        info.score = searched.score;
+        info.depth = searched.depth;
+        info.nodes = nodes;
+        info.timeMs = timeMs;
+        if (!searched.move.empty()) {
+            info.pv = principalVariation(request.board, request.toMove, searched.depth);
+            if (info.pv.empty() || info.pv[0] != searched.move) {
+                info.pv = {searched.move};  // the root entry was overwritten by another request
+            }
+        }
+        return info;
+    }
+
+    // stop searches that are over their limits or cancelled
+    void watch() {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (shuttingDown) {
+                    return;
+                }
+                const auto now = std::chrono::steady_clock::now();
+                for (Worker& worker : workers) {
+                    if (worker.job && (*worker.job->cancelled || now >= worker.deadline ||
+                                       (worker.job->request.nodes > 0 &&
+                                        worker.nodes.load(std::memory_order_relaxed) >= worker.job->request.nodes))) {
+                        worker.stop = true;
+                    }
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+#endif // ABALONE_ANALYSIS_POOL_H
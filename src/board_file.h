@@ -0,0 +1,64 @@
+#ifndef ABALONE_BOARD_FILE_H
+#define ABALONE_BOARD_FILE_H
+
+#include "engine.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+/*
+ * Reading boards from input files: first line is the player to move ("b" or "w"),
+ * second line the marbles, e.g. "C5b,D5b,E4b,...".
+ * Kept out of engine.h so builds that never touch files (the browser module) don't pull in iostreams.
+ */
+
+inline void parseFile(const std::string& filename, AbaloneBoard& board, CellState& playerToMove) {
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return;
+    }
+
+    std::string line;
+    std::getline(file, line); // Read the first line to determine the player to move
+    playerToMove = (line[0] == 'b') ? CellState::BLACK : CellState::WHITE;
+
+    std::getline(file, line); // Read the second line to get the marble positions
+    std::istringstream iss(line);
+    std::string marble;
+    while (std::getline(iss, marble, ',')) {
+        std::string pos = marble.substr(0, 2);
+        CellState state = (marble.back() == 'b') ? CellState::BLACK : CellState::WHITE;
+        board.setCellState(pos, state);
+    }
+    file.close();
+    if (!hasValidMarbleCounts(board)) {
+        std::cerr << "Error: more than " << MARBLES_PER_SIDE << " marbles of one colour in " << filename << std::endl;
+        board = AbaloneBoard();
+    }
+}
+
+// helper function to parse the board state from the second line of the file
+inline std::unordered_map<std::string, char> parseBoard(const std::string& boardFile) {
+    std::unordered_map<std::string, char> boardState;
+    std::ifstream infile(boardFile);
+
+    // Skip the first line
+    std::string line;
+    std::getline(infile, line);
+
+    // Read the second line (the actual board)
+    if (std::getline(infile, line)) {
+        std::stringstream ss(line);
+        std::string position;
+        while (std::getline(ss, position, ',')) {
+            char color = position.back();
+            std::string pos = position.substr(0, position.size() - 1); // Remove color from position
+            boardState[pos] = color;
+        }
+    }
+    return boardState;
+}
+
+#endif // ABALONE_BOARD_FILE_H
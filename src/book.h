@@ -0,0 +1,202 @@
+#ifndef ABALONE_BOOK_H
+#define ABALONE_BOOK_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+/*
+ * Opening book file layout (all fields little-endian, as written by the builder):
+ *   BookHeader
+ *   uint32_t bucketStart[(1 << bucketBits) + 1]   index of the first entry in each bucket
+ *   BookEntry entries[entryCount]                  sorted by key
+ * The bucket of a key is its top bucketBits bits, so a probe is one index lookup
+ * plus a scan of a bucket that holds about one entry.
+ */
+
+const char BOOK_MAGIC[8] = {'A', 'B', 'A', 'B', 'O', 'O', 'K', '\0'};
+const uint32_t BOOK_VERSION = 1;
+
+struct BookHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t bucketBits;
+    uint32_t reserved;
+};
+
+// one book position: zobrist key of the board + side to move, and the move to play
+struct BookEntry {
+    uint64_t key;
+    char move[8];
+};
+
+// sort entries, build the bucket index and write the book file
+inline bool writeOpeningBook(const std::string& filename, std::vector<BookEntry> entries) {
+    std::sort(entries.begin(), entries.end(),
+              [](const BookEntry& a, const BookEntry& b) { return a.key < b.key; });
+    entries.erase(std::unique(entries.begin(), entries.end(),
+                              [](const BookEntry& a, const BookEntry& b) { return a.key == b.key; }),
+                  entries.end());
+
+    // about one entry per bucket
+    uint32_t bucketBits = 1;
+    while (bucketBits < 24 && (1u << bucketBits) < entries.size()) {
+        bucketBits++;
+    }
+    const uint32_t bucketCount = 1u << bucketBits;
+    std::vector<uint32_t> bucketStart(bucketCount + 1, 0);
+    size_t next = 0;
+    for (uint32_t bucket = 0; bucket <= bucketCount; bucket++) {
+        while (next < entries.size() && (entries[next].key >> (64 - bucketBits)) < bucket) {
+            next++;
+        }
+        bucketStart[bucket] = static_cast<uint32_t>(next);
+    }
+    bucketStart[bucketCount] = static_cast<uint32_t>(entries.size());
+
+    BookHeader header{};
+    std::memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    header.version = BOOK_VERSION;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.bucketBits = bucketBits;
+
+    FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+              std::fwrite(bucketStart.data(), sizeof(uint32_t), bucketStart.size(), file) == bucketStart.size() &&
+              std::fwrite(entries.data(), sizeof(BookEntry), entries.size(), file) == entries.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+// read-only opening book, either memory-mapped from a file or attached to bytes already in memory
+class OpeningBook {
+    const char* data = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    const BookHeader* header = nullptr;
+    const uint32_t* bucketStart = nullptr;
+    const BookEntry* entries = nullptr;
+
+public:
+    OpeningBook() = default;
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    ~OpeningBook() {
+        close();
+    }
+
+    // map a book file; returns false (and leaves the book empty) if it is missing or malformed
+    bool open(const std::string& filename) {
+        close();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1) {
+            return false;
+        }
+        struct stat sb{};
+        if (fstat(fd, &sb) == -1 || static_cast<size_t>(sb.st_size) < sizeof(BookHeader)) {
+            ::close(fd);
+            return false;
+        }
+        const size_t fileLength = sb.st_size;
+        void* addr = mmap(nullptr, fileLength, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // the mapping stays valid after closing the descriptor
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        if (!attach(static_cast<const char*>(addr), fileLength)) {
+            munmap(addr, fileLength);
+            return false;
+        }
+        mapped = true;
+        return true;
+    }
+
+    // use a book that is already in memory (e.g. downloaded by the browser); the bytes must
+    // outlive the book. Returns false (and leaves the book empty) if they are malformed.
+    bool attach(const char* bytes, size_t size) {
+        close();
+        if (size < sizeof(BookHeader)) {
+            return false;
+        }
+        const auto* bookHeader = reinterpret_cast<const BookHeader*>(bytes);
+        if (std::memcmp(bookHeader->magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0 || bookHeader->version != BOOK_VERSION) {
+            return false;
+        }
+
+        // a probe shifts the key right by 64 - bucketBits, so 1 to 63 bits; the bucket index
+        // must fit in the bytes before its size is worked out
+        const uint32_t bucketBits = bookHeader->bucketBits;
+        const uint64_t indexRoom = (size - sizeof(BookHeader)) / sizeof(uint32_t);
+        if (bucketBits == 0 || bucketBits > 63 || (uint64_t{1} << bucketBits) >= indexRoom) {
+            return false;
+        }
+        const size_t bucketCount = size_t{1} << bucketBits;
+        const size_t expected = sizeof(BookHeader) + (bucketCount + 1) * sizeof(uint32_t) +
+                                size_t{bookHeader->entryCount} * sizeof(BookEntry);
+        if (size < expected) {
+            return false;
+        }
+
+        // every bucket must be a range of the entries: the starts never go down or past the end
+        const auto* starts = reinterpret_cast<const uint32_t*>(bytes + sizeof(BookHeader));
+        for (size_t bucket = 0; bucket <= bucketCount; bucket++) {
+            if (starts[bucket] > bookHeader->entryCount || (bucket > 0 && starts[bucket] < starts[bucket - 1])) {
+                return false;
+            }
+        }
+
+        data = bytes;
+        length = size;
+        header = bookHeader;
+        bucketStart = starts;
+        entries = reinterpret_cast<const BookEntry*>(bucketStart + bucketCount + 1);
+        return true;
+    }
+
+    void close() {
+        if (data && mapped) {
+            munmap(const_cast<char*>(data), length);
+        }
+        mapped = false;
+        data = nullptr;
+        length = 0;
+        header = nullptr;
+        bucketStart = nullptr;
+        entries = nullptr;
+    }
+
+    [[nodiscard]] bool isOpen() const {
+        return data != nullptr;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return header ? header->entryCount : 0;
+    }
+
+    // book move for a position key, or an empty string if the position is not in the book
+    [[nodiscard]] std::string probe(uint64_t key) const {
+        if (!data) {
+            return "";
+        }
+        const uint64_t bucket = key >> (64 - header->bucketBits);
+        for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1]; i++) {
+            if (entries[i].key == key) {
+                return std::string(entries[i].move, strnlen(entries[i].move, sizeof(entries[i].move)));
+            }
+        }
+        return "";
+    }
+};
+
+#endif // ABALONE_BOOK_H
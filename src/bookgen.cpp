@@ -0,0 +1,89 @@
+#include "engine.h"
+#include "book.h"
+
+#include <iostream>
+#include <set>
+
+/*
+ * Build the opening book: search every position within the first N plies of the
+ * three standard layouts (with either colour moving first) and store the best move
+ * for each one.
+ *
+ * usage: bookgen [output file] [plies] [search depth]
+ */
+
+struct BookBuilder {
+    int plies;
+    SearchParams params;
+    std::vector<BookEntry> entries;
+    std::set<uint64_t> visited;
+
+    void expand(const AbaloneBoard& board, CellState toMove, int ply) {
+        const uint64_t key = hashBoard(board, toMove);
+        if (!visited.insert(key).second) {
+            return;  // transposition, already searched
+        }
+
+        // positions in the book are searched from scratch so results don't depend on visiting order
+        transpositionTable.clear();
+        AbaloneBoard searchBoard = board;
+        const std::string bestMove = searchBestMove(searchBoard, toMove, params).move;
+        if (bestMove.empty() || bestMove.size() >= sizeof(BookEntry::move)) {
+            return;
+        }
+        BookEntry entry{};
+        entry.key = key;
+        std::memcpy(entry.move, bestMove.data(), bestMove.size());
+        entries.push_back(entry);
+
+        if (entries.size() % 100 == 0) {
+            std::cout << entries.size() << " positions searched" << std::endl;
+        }
+        if (ply + 1 >= plies) {
+            return;
+        }
+
+        const CellState opponent = (toMove == CellState::BLACK) ? CellState::WHITE : CellState::BLACK;
+        const std::vector<std::string> legalMoves = board.generateLegalMoves(toMove);
+        for (const std::string& boardString : generateBoardStates(board, legalMoves)) {
+            AbaloneBoard child;
+            for (const auto& [pos, color] : parseBoardFromString(boardString)) {
+                child.setCellState(pos, color == 'b' ? CellState::BLACK : CellState::WHITE);
+            }
+            expand(child, opponent, ply + 1);
+        }
+    }
+};
+
+int main(int argc, char* argv[]) {
+    const std::string outputFileName = (argc > 1) ? argv[1] : "opening.book";
+    BookBuilder builder;
+    builder.plies = (argc > 2) ? std::atoi(argv[2]) : 2;
+    // offline, so search one ply deeper than the game does by default
+    builder.params.depth = (argc > 3) ? std::atoi(argv[3]) : SearchParams().depth + 1;
+    if (builder.plies < 1 || builder.params.depth < 1) {
+        std::cerr << "usage: bookgen [output file] [plies >= 1] [depth >= 1]" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int layoutChoice = 1; layoutChoice <= 3; layoutChoice++) {
+        AbaloneBoard board;
+        for (const auto& [pos, color] : parseBoardFromString(layoutString(layoutChoice))) {
+            board.setCellState(pos, color == 'b' ? CellState::BLACK : CellState::WHITE);
+        }
+        builder.expand(board, CellState::BLACK, 0);
+        builder.expand(board, CellState::WHITE, 0);
+        std::cout << "Layout " << layoutChoice << " done, " << builder.entries.size() << " positions" << std::endl;
+    }
+
+    if (!writeOpeningBook(outputFileName, builder.entries)) {
+        std::cerr << "Error: Could not write " << outputFileName << std::endl;
+        return 1;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::seconds>(end - start);
+    std::cout << "Wrote " << builder.entries.size() << " positions to " << outputFileName
+              << " in " << duration.count() << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,2260 @@
+#ifndef ABALONE_ENGINE_H
+#define ABALONE_ENGINE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include <cstdlib>
+#include <cmath>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <deque>
+#include <utility>
+
+#include "movelist.h"
+#include "trace.h"
+
+const int MAX_MOVES = 40;
+
+// represents the states of a cell: black, empty, or white
+enum class CellState { EMPTY, BLACK, WHITE };
+
+// the 6 directions a marble can move in
+const std::vector<std::string> directions = {"NE", "NW", "E", "W", "SE", "SW"};
+
+// represents a cell in the game board
+struct Cell {
+    CellState state = CellState::EMPTY;
+};
+
+// number of cells on the board
+const int NUM_CELLS = 61;
+
+// names of the cells, indexed by cell index
+const std::array<std::string, NUM_CELLS> cellNames = {
+    "A1", "A2", "A3", "A4", "A5",
+    "B1", "B2", "B3", "B4", "B5", "B6",
+    "C1", "C2", "C3", "C4", "C5", "C6", "C7",
+    "D1", "D2", "D3", "D4", "D5", "D6", "D7", "D8",
+    "E1", "E2", "E3", "E4", "E5", "E6", "E7", "E8", "E9",
+    "F2", "F3", "F4", "F5", "F6", "F7", "F8", "F9",
+    "G3", "G4", "G5", "G6", "G7", "G8", "G9",
+    "H4", "H5", "H6", "H7", "H8", "H9",
+    "I5", "I6", "I7", "I8", "I9"
+};
+
+constexpr int ROW_START[] = {0, 5, 11, 18, 26, 35, 43, 50, 56};  // index of the first cell of rows A..I
+constexpr int FIRST_DIGIT[] = {1, 1, 1, 1, 1, 2, 3, 4, 5};         // digit of the first cell of rows A..I
+
+// map a valid position like "E5" to a cell index 0..60, ordered A1..I9 like boardToString
+inline int cellIndex(std::string_view pos) {
+    const int row = pos[0] - 'A';
+    return ROW_START[row] + (pos[1] - '0') - FIRST_DIGIT[row];
+}
+
+// direction indices follow `directions`: NE, NW, E, W, SE, SW
+const int DIRECTION_COUNT = 6;
+constexpr int DIRECTION_DELTA[DIRECTION_COUNT][2] = {{1, 1}, {1, 0}, {0, 1}, {0, -1}, {-1, 0}, {-1, -1}};  // row, digit
+
+inline int directionIndex(std::string_view dir) {
+    for (int d = 0; d < DIRECTION_COUNT; d++) {
+        if (directions[d] == dir) return d;
+    }
+    return -1;
+}
+
+// row (0 = A), digit and neighbours of every cell, computed at compile time
+struct BoardGeometry {
+    std::array<int, NUM_CELLS> row{};
+    std::array<int, NUM_CELLS> digit{};
+    std::array<std::array<int, DIRECTION_COUNT>, NUM_CELLS> neighbour{};  // cell index, -1 off the board
+};
+
+constexpr int rowLength(int row) {
+    return (row < 4) ? row + 5 : 13 - row;
+}
+
+constexpr bool isOnBoard(int row, int digit) {
+    return row >= 0 && row < 9 && digit >= FIRST_DIGIT[row] && digit < FIRST_DIGIT[row] + rowLength(row);
+}
+
+constexpr BoardGeometry makeBoardGeometry() {
+    BoardGeometry geometry;
+    for (int row = 0; row < 9; row++) {
+        for (int column = 0; column < rowLength(row); column++) {
+            geometry.row[ROW_START[row] + column] = row;
+            geometry.digit[ROW_START[row] + column] = FIRST_DIGIT[row] + column;
+        }
+    }
+    for (int index = 0; index < NUM_CELLS; index++) {
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            const int row = geometry.row[index] + DIRECTION_DELTA[d][0];
+            const int digit = geometry.digit[index] + DIRECTION_DELTA[d][1];
+            geometry.neighbour[index][d] = isOnBoard(row, digit) ? ROW_START[row] + digit - FIRST_DIGIT[row] : -1;
+        }
+    }
+    return geometry;
+}
+
+constexpr BoardGeometry boardGeometry = makeBoardGeometry();
+
+// A set of cells as a bitboard: bit i is cell i.
+using CellMask = uint64_t;
+
+constexpr CellMask ALL_CELLS = (CellMask(1) << NUM_CELLS) - 1;
+
+inline int popCount(CellMask mask) {
+#ifdef __POPCNT__
+    return __builtin_popcountll(mask);
+#else
+    // without the popcnt instruction the builtin is a library call; this stays inline
+    mask -= (mask >> 1) & 0x5555555555555555ULL;
+    mask = (mask & 0x3333333333333333ULL) + ((mask >> 2) & 0x3333333333333333ULL);
+    mask = (mask + (mask >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((mask * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+inline int lowestCell(CellMask mask) {
+    return __builtin_ctzll(mask);
+}
+
+// Moving a set of cells one step in a direction adds the same offset to the index of every cell
+// of a row, and rows share offsets, so a step is at most this many mask-and-shift groups.
+constexpr int MAX_SHIFT_GROUPS = 4;
+
+struct DirectionShift {
+    std::array<CellMask, MAX_SHIFT_GROUPS> from{};  // cells that move by offset (their neighbour is on the board)
+    std::array<int, MAX_SHIFT_GROUPS> offset{};
+    CellMask edge = 0;                              // cells with no neighbour in this direction
+};
+
+constexpr std::array<DirectionShift, DIRECTION_COUNT> makeDirectionShifts() {
+    std::array<DirectionShift, DIRECTION_COUNT> shifts{};
+    for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+        DirectionShift& shift = shifts[dir];
+        int groups = 0;
+        for (int index = 0; index < NUM_CELLS; index++) {
+            const int target = boardGeometry.neighbour[index][dir];
+            if (target < 0) {
+                shift.edge |= CellMask(1) << index;
+                continue;
+            }
+            int group = 0;
+            while (group < groups && shift.offset[group] != target - index) {
+                group++;
+            }
+            if (group == groups) {
+                shift.offset[groups++] = target - index;  // out of range (no constant) if MAX_SHIFT_GROUPS is too small
+            }
+            shift.from[group] |= CellMask(1) << index;
+        }
+    }
+    return shifts;
+}
+
+constexpr std::array<DirectionShift, DIRECTION_COUNT> directionShifts = makeDirectionShifts();
+
+template <int Dir, int... Groups>
+inline CellMask shiftCells(CellMask mask, std::integer_sequence<int, Groups...>) {
+    constexpr const DirectionShift& shift = directionShifts[Dir];
+    auto moveGroup = [mask](auto group) -> CellMask {
+        constexpr int offset = shift.offset[decltype(group)::value];
+        const CellMask moving = mask & shift.from[decltype(group)::value];
+        if constexpr (offset >= 0) {
+            return moving << offset;
+        } else {
+            return moving >> -offset;
+        }
+    };
+    return (moveGroup(std::integral_constant<int, Groups>()) | ...);
+}
+
+// the neighbours in direction Dir of the cells in mask (cells stepping off the board are dropped);
+// the direction is a template argument so the masks and shifts are constants
+template <int Dir>
+inline CellMask shiftCells(CellMask mask) {
+    return shiftCells<Dir>(mask, std::make_integer_sequence<int, MAX_SHIFT_GROUPS>());
+}
+
+template <typename Fn, int... Dirs>
+inline void forEachDirection(Fn&& fn, std::integer_sequence<int, Dirs...>) {
+    (fn(std::integral_constant<int, Dirs>()), ...);
+}
+
+// fn(std::integral_constant<int, Dir>()) for the first Count directions (all of them by
+// default, the NE, NW and E axes with 3), for shiftCells<Dir>
+template <int Count = DIRECTION_COUNT, typename Fn>
+inline void forEachDirection(Fn&& fn) {
+    forEachDirection(fn, std::make_integer_sequence<int, Count>());
+}
+
+// the outer ring of the board
+constexpr CellMask EDGE_CELLS = [] {
+    CellMask edge = 0;
+    for (const DirectionShift& shift : directionShifts) {
+        edge |= shift.edge;
+    }
+    return edge;
+}();
+
+// Hex distance between every two cells: the number of steps from one to the other. Rows and
+// digits are axial coordinates (a step changes the row, the digit or both by one in the same
+// direction), so the distance is the largest of the row gap, the digit gap and their difference.
+constexpr std::array<std::array<uint8_t, NUM_CELLS>, NUM_CELLS> makeCellDistances() {
+    std::array<std::array<uint8_t, NUM_CELLS>, NUM_CELLS> distances{};
+    for (int a = 0; a < NUM_CELLS; a++) {
+        for (int b = 0; b < NUM_CELLS; b++) {
+            const int rows = boardGeometry.row[a] - boardGeometry.row[b];
+            const int digits = boardGeometry.digit[a] - boardGeometry.digit[b];
+            const int skew = rows - digits;
+            distances[a][b] = static_cast<uint8_t>(
+                std::max({rows < 0 ? -rows : rows, digits < 0 ? -digits : digits, skew < 0 ? -skew : skew}));
+        }
+    }
+    return distances;
+}
+
+constexpr std::array<std::array<uint8_t, NUM_CELLS>, NUM_CELLS> cellDistances = makeCellDistances();
+
+constexpr int cellDistance(int a, int b) {
+    return cellDistances[a][b];
+}
+
+constexpr CellState opponentOf(CellState player) {
+    return (player == CellState::BLACK) ? CellState::WHITE : CellState::BLACK;
+}
+
+// zobrist keys: one per (cell, colour) plus one for the side to move.
+// generated from a fixed seed so hashes stay stable across builds (the opening book depends on it)
+struct ZobristKeys {
+    std::array<std::array<uint64_t, 2>, NUM_CELLS> cell{};
+    uint64_t blackToMove = 0;
+};
+
+constexpr uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys;
+    uint64_t state = 0xABA10E;
+    for (auto& cell : keys.cell) {
+        cell[0] = splitMix64(state);
+        cell[1] = splitMix64(state);
+    }
+    keys.blackToMove = splitMix64(state);
+    return keys;
+}
+
+constexpr ZobristKeys zobristKeys = makeZobristKeys();
+
+// the key of a cell's state, 0 for an empty cell
+constexpr uint64_t zobristKey(int cell, CellState state) {
+    return (state == CellState::EMPTY) ? 0 : zobristKeys.cell[cell][state == CellState::BLACK ? 0 : 1];
+}
+
+// cells changed by AbaloneBoard::makeMove and what they held before, for unmakeMove
+struct MoveUndo {
+    int count = 0;
+    std::array<int, 10> cells{};  // an inline move changes at most a line of 9 cells and the cell beyond
+    std::array<CellState, 10> states{};
+    bool pushOff = false;         // a marble left the board: no earlier position can come back
+};
+
+// abalone game board consisting of cells
+class AbaloneBoard {
+    std::array<Cell, NUM_CELLS> board{};  // indexed by cellIndex, all cells empty initially
+    uint64_t key = 0;                     // zobrist key of the marbles, kept up to date by every change
+
+public:
+    // Getter for the board
+    [[nodiscard]] const std::array<Cell, NUM_CELLS>& getBoard() const {
+        return board;
+    }
+
+    // change a cell's state
+    void setCellState(const std::string& pos, CellState state) {
+        if (isValidPosition(pos)) {
+            place(cellIndex(pos), state);
+        }
+    }
+
+    void setCellState(int index, CellState state) {
+        place(index, state);
+    }
+
+    // zobrist key of the marbles without the side to move (see hashBoard)
+    [[nodiscard]] uint64_t positionKey() const {
+        return key;
+    }
+
+
+    // Generate a string representing the current state of the board
+    std::string boardToString() const {
+        std::string result;
+        boardToString(result);
+        return result;
+    }
+
+    // same, written into result so the caller can reuse its capacity
+    void boardToString(std::string& result) const {
+        TRACE_SCOPE("boardToString");
+        result.clear();
+        for (int index = 0; index < NUM_CELLS; index++) {
+            const std::string& position = cellNames[index];
+            const Cell& cell = board[index];
+
+            char color = (cell.state == CellState::BLACK) ? 'b' :
+                         (cell.state == CellState::WHITE) ? 'w' : ' ';
+
+            if (color != ' ') {
+                result += position + color + ",";
+            }
+        }
+        // Remove the trailing comma, if there is one
+        if (!result.empty()) {
+            result.pop_back();
+        }
+    }
+
+
+    // access a cell's state
+    [[nodiscard]] CellState getCellState(const std::string& pos) const {
+        if (isValidPosition(pos)) {
+            return board[cellIndex(pos)].state;
+        }
+        return CellState::EMPTY;
+    }
+
+    // check if a position is valid (i.e., is on the board)
+    [[nodiscard]] static bool isValidPosition(const std::string& pos) {
+        if (pos.size() != 2) {
+            return false;
+        }
+        char col = pos[0];
+        int row = pos[1] - '0';
+
+        // Ensure the position is within the valid row-column bounds
+        return (col >= 'A' && col <= 'I') &&
+               ((col == 'A' && row >= 1 && row <= 5) ||
+                (col == 'B' && row >= 1 && row <= 6) ||
+                (col == 'C' && row >= 1 && row <= 7) ||
+                (col == 'D' && row >= 1 && row <= 8) ||
+                (col == 'E' && row >= 1 && row <= 9) ||
+                (col == 'F' && row >= 2 && row <= 9) ||
+                (col == 'G' && row >= 3 && row <= 9) ||
+                (col == 'H' && row >= 4 && row <= 9) ||
+                (col == 'I' && row >= 5 && row <= 9));
+    }
+
+    // Generate all legal moves for a player
+    [[nodiscard]] std::vector<std::string> generateLegalMoves(CellState player) const {
+        MoveList moveList;
+        generateLegalMoves(player, moveList);
+        std::vector<std::string> legalMoves;
+        legalMoves.reserve(moveList.size());
+        for (const Move& move : moveList) {
+            legalMoves.push_back(move.str());
+        }
+        return legalMoves;
+    }
+
+    // same, written into legalMoves (cleared first)
+    void generateLegalMoves(CellState player, MoveList& legalMoves) const {
+        if (player == CellState::BLACK) {
+            generateLegalMoves<CellState::BLACK>(legalMoves);
+        } else {
+            generateLegalMoves<CellState::WHITE>(legalMoves);
+        }
+    }
+
+    // The generators are specialised for the side to move (Us), so the colour comparisons in
+    // the loops are against constants. The search calls these directly.
+    template <CellState Us>
+    void generateLegalMoves(MoveList& legalMoves) const {
+        TRACE_SCOPE("generateLegalMoves");
+        legalMoves.clear();
+
+        // Single marble moves
+        generateSingleMarbleMoves<Us>(legalMoves);
+
+        // Inline moves for 2 marbles
+        generateDoubleInlineMoves<Us>(legalMoves);
+
+        // Inline moves for 3 marbles
+        generateTripleInlineMoves<Us>(legalMoves);
+
+        // Sidestep moves for 2 marbles
+        generateDoubleSidestepMoves<Us>(legalMoves);
+
+        // Sidestep moves for 3 marbles
+        generateTripleSidestepMoves<Us>(legalMoves);
+    }
+
+    // Generate only the sumito moves (2 or 3 marbles inline pushing 1 or 2 opponent marbles).
+    // Pushes that knock a marble off the board are listed first; returns how many there are.
+    size_t generatePushMoves(const CellState player, MoveList& pushMoves) const {
+        return (player == CellState::BLACK) ? generatePushMoves<CellState::BLACK>(pushMoves)
+                                            : generatePushMoves<CellState::WHITE>(pushMoves);
+    }
+
+    template <CellState Us>
+    size_t generatePushMoves(MoveList& pushMoves) const {
+        constexpr CellState Them = opponentOf(Us);
+        size_t pushOffCount = 0;
+        for (int index = 0; index < NUM_CELLS; index++) {
+            if (board[index].state != Us) {
+                continue;
+            }
+            for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+                // count our marbles in line starting at index, then the opponent marbles in front of them
+                int front = neighbour(index, dir);
+                int ownCount = 1;
+                while (ownCount <= 3 && stateAt(front) == Us) {
+                    ownCount++;
+                    front = neighbour(front, dir);
+                }
+                if (ownCount < 2 || ownCount > 3) {
+                    continue;
+                }
+                int opponentCount = 0;
+                while (opponentCount < ownCount && stateAt(front) == Them) {
+                    opponentCount++;
+                    front = neighbour(front, dir);
+                }
+                // need a smaller opponent line followed by an empty cell or the edge of the board
+                if (opponentCount == 0 || opponentCount >= ownCount) {
+                    continue;
+                }
+                const bool pushOff = front < 0;
+                if (!pushOff && board[front].state != CellState::EMPTY) {
+                    continue;
+                }
+                const Move move('i', cellNames[index], directions[dir]);
+                if (pushOff) {
+                    pushMoves.insert(pushOffCount, move);
+                    pushOffCount++;
+                } else {
+                    pushMoves.push_back(move);
+                }
+            }
+        }
+        return pushOffCount;
+    }
+
+    // check if a player can push an opponent marble off the board this move
+    [[nodiscard]] bool canPushOff(const CellState player) const {
+        return (player == CellState::BLACK) ? canPushOff<CellState::BLACK>() : canPushOff<CellState::WHITE>();
+    }
+
+    template <CellState Us>
+    [[nodiscard]] bool canPushOff() const {
+        thread_local MoveList pushMoves;  // not on the stack: this is called at every search node
+        pushMoves.clear();
+        return generatePushMoves<Us>(pushMoves) > 0;
+    }
+
+    // Play a move on this board in place; unmakeMove with the returned record takes it back.
+    // Inline moves shift the line of marbles starting at the moving marble one step, a marble
+    // at the edge falls off. Sidesteps move each marble of the group one step.
+    // Like applyMove the move is not checked for legality.
+    MoveUndo makeMove(const Move& move) {
+        TRACE_SCOPE("makeMove");
+        const std::string_view text = move.view();
+        MoveUndo undo;
+        auto save = [&](int cell) {
+            undo.cells[undo.count] = cell;
+            undo.states[undo.count] = board[cell].state;
+            undo.count++;
+        };
+
+        if (text[0] == 'i') {
+            const int dir = directionIndex(text.substr(3));
+            std::array<int, 9> line{};
+            int length = 0;
+            for (int cell = cellIndex(text.substr(1, 2)); stateAt(cell) != CellState::EMPTY; cell = neighbour(cell, dir)) {
+                line[length++] = cell;
+            }
+            if (length == 0) {
+                return undo;
+            }
+            for (int i = 0; i < length; i++) {
+                save(line[i]);
+            }
+            const int destination = neighbour(line[length - 1], dir);
+            if (destination >= 0) {
+                save(destination);
+                place(destination, board[line[length - 1]].state);
+            } else {
+                undo.pushOff = true;  // the last marble of the line falls off
+            }
+            for (int i = length - 1; i > 0; i--) {
+                place(line[i], board[line[i - 1]].state);
+            }
+            place(line[0], CellState::EMPTY);
+        } else if (text[0] == 's') {
+            const int first = cellIndex(text.substr(1, 2));
+            const int last = cellIndex(text.substr(3, 2));
+            const int dir = directionIndex(text.substr(5));
+            std::array<int, 3> group = {first, last, -1};
+            int groupSize = 2;
+            if (!isNeighbour(first, last)) {
+                // three marbles: the middle one is halfway between the ends
+                const int row = (boardGeometry.row[first] + boardGeometry.row[last]) / 2;
+                const int digit = (boardGeometry.digit[first] + boardGeometry.digit[last]) / 2;
+                group[groupSize++] = ROW_START[row] + digit - FIRST_DIGIT[row];
+            }
+            std::array<CellState, 3> states{};
+            for (int i = 0; i < groupSize; i++) {
+                save(group[i]);
+                states[i] = board[group[i]].state;
+                place(group[i], CellState::EMPTY);
+            }
+            for (int i = 0; i < groupSize; i++) {
+                if (const int target = neighbour(group[i], dir); target >= 0) {
+                    save(target);
+                    place(target, states[i]);
+                }
+            }
+        }
+        return undo;
+    }
+
+    void unmakeMove(const MoveUndo& undo) {
+        for (int i = undo.count - 1; i >= 0; i--) {
+            place(undo.cells[i], undo.states[i]);
+        }
+    }
+
+
+
+
+    // Helper function to get the adjacent position in a given direction
+    static std::string getAdjacentPosition(const std::string& pos, const std::string& dir) {
+        const char col = pos[0];
+        const int row = pos[1] - '0';
+
+        // Not sure if these are necessary since we validate position elsewhere
+        // Keep them for now just in case
+
+        // For each direction, check the movement and ensure the new position is within bounds
+        std::string adjPos;
+
+        if (dir == "NE") {
+
+            adjPos = std::string(1, col + 1) + std::to_string(row + 1);
+
+        } else if (dir == "E") {
+                adjPos = std::string(1, col) + std::to_string(row + 1);
+        } else if (dir == "NW") {
+                adjPos = std::string(1, col + 1) + std::to_string(row);
+        } else if (dir == "SE") {
+                adjPos = std::string(1, col - 1) + std::to_string(row);
+        } else if (dir == "W") {
+                adjPos = std::string(1, col) + std::to_string(row - 1);
+        } else if (dir == "SW") {
+                adjPos = std::string(1, col - 1) + std::to_string(row - 1);
+        }
+
+        // If the adjacent position is valid, return it, otherwise return an empty string
+        return adjPos.empty() || !isValidPosition(adjPos) ? std::string() : adjPos;
+    }
+
+private:
+    // every change of a cell goes through here, to keep the key
+    void place(int cell, CellState state) {
+        key ^= zobristKey(cell, board[cell].state) ^ zobristKey(cell, state);
+        board[cell].state = state;
+    }
+
+    // neighbouring cell in a direction, -1 off the board (and for cell -1)
+    static int neighbour(int cell, int dir) {
+        return (cell < 0) ? -1 : boardGeometry.neighbour[cell][dir];
+    }
+
+    static bool isNeighbour(int cell, int other) {
+        for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+            if (boardGeometry.neighbour[cell][dir] == other) return true;
+        }
+        return false;
+    }
+
+    // state of a cell, off-board cells (-1) count as empty
+    [[nodiscard]] CellState stateAt(int cell) const {
+        return (cell < 0) ? CellState::EMPTY : board[cell].state;
+    }
+
+    // Generate legal single marble moves
+    template <CellState Us>
+    void generateSingleMarbleMoves(MoveList& legalMoves) const {
+        for (int index = 0; index < NUM_CELLS; index++) {
+            if (board[index].state == Us) {
+                // for each direction, log the move if the target cell is on the board and empty
+                for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+                    if (isLegalInlineMove<Us>(index, dir, 1)) {
+                        legalMoves.push_back(Move('i', cellNames[index], directions[dir]));
+                    }
+                }
+            }
+        }
+    }
+
+    // Can the line of exactly size marbles starting at index and running in dir move one step in dir?
+    // The cell in front must be empty, or hold fewer opponent marbles than we move followed by an
+    // empty cell or the edge of the board (sumito). Our own marbles never leave the board.
+    template <CellState Us>
+    bool isLegalInlineMove(int index, int dir, int size) const {
+        constexpr CellState Them = opponentOf(Us);
+        int front = index;
+        for (int i = 1; i < size; i++) {
+            front = neighbour(front, dir);
+            if (stateAt(front) != Us) {
+                return false;
+            }
+        }
+        front = neighbour(front, dir);
+        if (front < 0) {
+            return false;
+        }
+        int opponentCount = 0;
+        while (stateAt(front) == Them) {
+            opponentCount++;
+            front = neighbour(front, dir);
+        }
+        if (opponentCount == 0) {
+            return board[front].state == CellState::EMPTY;
+        }
+        return opponentCount < size && stateAt(front) == CellState::EMPTY;
+    }
+
+    // Generate inline moves for 2 marbles (moves and 2-on-1 pushes)
+    template <CellState Us>
+    void generateDoubleInlineMoves(MoveList& legalMoves) const {
+        for (int index = 0; index < NUM_CELLS; index++) {
+            if (board[index].state == Us) {
+                for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+                    if (isLegalInlineMove<Us>(index, dir, 2)) {
+                        legalMoves.push_back(Move('i', cellNames[index], directions[dir]));
+                    }
+                }
+            }
+        }
+    }
+
+    // Generate inline moves for 3 marbles (moves, 3-on-1 and 3-on-2 pushes)
+    template <CellState Us>
+    void generateTripleInlineMoves(MoveList& legalMoves) const {
+        for (int index = 0; index < NUM_CELLS; index++) {
+            if (board[index].state == Us) {
+                for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+                    if (isLegalInlineMove<Us>(index, dir, 3)) {
+                        legalMoves.push_back(Move('i', cellNames[index], directions[dir]));
+                    }
+                }
+            }
+        }
+    }
+
+    // Generate sidestep moves for 2 marbles
+    template <CellState Us>
+    void generateDoubleSidestepMoves(MoveList& legalMoves) const {
+        // sidestep directions for a pair lying along each direction (NE, NW, E, W, SE, SW)
+        static constexpr int sidestepDirs[DIRECTION_COUNT][4] = {
+            {2, 3, 1, 4}, {2, 3, 0, 5}, {0, 4, 1, 5}, {0, 4, 1, 5}, {2, 3, 0, 5}, {2, 3, 1, 4}};
+        for (int index = 0; index < NUM_CELLS; index++) {
+            if (board[index].state == Us) {
+                // check all 6 directions
+                for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+                    const int adjacent = neighbour(index, dir);
+                    // cells are indexed in position order, so this lists each pair once
+                    if (adjacent < index || board[adjacent].state != Us) {
+                        continue;
+                    }
+                    for (const int sidestepDir : sidestepDirs[dir]) {
+                        const int target1 = neighbour(index, sidestepDir);
+                        const int target2 = neighbour(adjacent, sidestepDir);
+                        if (target1 >= 0 && target2 >= 0 && board[target1].state == CellState::EMPTY &&
+                            board[target2].state == CellState::EMPTY) {
+                            legalMoves.push_back(Move('s', cellNames[index], cellNames[adjacent], directions[sidestepDir]));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Generate sidestep moves for 3 marbles
+    template <CellState Us>
+    void generateTripleSidestepMoves(MoveList& legalMoves) const {
+        for (int index = 0; index < NUM_CELLS; index++) {
+            if (board[index].state == Us) {
+                // Check for two more adjacent marbles in one of the 6 directions
+                for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+                    const int second = neighbour(index, dir);
+                    const int third = neighbour(second, dir);
+                    // skip duplicates: each line is listed from its first cell in position order
+                    if (second < 0 || third < 0 || board[second].state != Us || board[third].state != Us ||
+                        index > third) {
+                        continue;
+                    }
+                    for (int sideDir = 0; sideDir < DIRECTION_COUNT; sideDir++) {
+                        // moves along the line are inline moves (opposite directions add up to 5)
+                        if (sideDir == dir || sideDir == DIRECTION_COUNT - 1 - dir) {
+                            continue;
+                        }
+                        const int target1 = neighbour(index, sideDir);
+                        const int target2 = neighbour(second, sideDir);
+                        const int target3 = neighbour(third, sideDir);
+                        if (target1 >= 0 && target2 >= 0 && target3 >= 0 &&
+                            board[target1].state == CellState::EMPTY &&
+                            board[target2].state == CellState::EMPTY &&
+                            board[target3].state == CellState::EMPTY) {
+                            legalMoves.push_back(Move('s', cellNames[index], cellNames[third], directions[sideDir]));
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+// determine if a position is valid
+inline bool isValidPosition(const std::string& pos) {
+    char col = pos[0];
+    int row = std::stoi(pos.substr(1));
+
+    // ensure the position is within bounds
+    return (col >= 'A' && col <= 'I') &&
+           ((col == 'A' && row >= 1 && row <= 5) ||
+            (col == 'B' && row >= 1 && row <= 6) ||
+            (col == 'C' && row >= 1 && row <= 7) ||
+            (col == 'D' && row >= 1 && row <= 8) ||
+            (col == 'E' && row >= 1 && row <= 9) ||
+            (col == 'F' && row >= 2 && row <= 9) ||
+            (col == 'G' && row >= 3 && row <= 9) ||
+            (col == 'H' && row >= 4 && row <= 9) ||
+            (col == 'I' && row >= 5 && row <= 9));
+}
+
+// helper function to clean the board strings
+inline std::string removeSingleCharValues(const std::string& input) {
+    std::string result;
+    size_t start = 0;
+
+    // split by commas, drop single character values and join the rest back with commas
+    while (start <= input.size()) {
+        size_t end = input.find(',', start);
+        if (end == std::string::npos) {
+            end = input.size();
+        }
+        if (end - start > 1) {
+            if (!result.empty()) {
+                result += ',';
+            }
+            result.append(input, start, end - start);
+        }
+        start = end + 1;
+    }
+    return result;
+}
+
+
+inline char getMiddleLetter(char a, char b) {
+    // ie. C,A -> B
+    return static_cast<char>((a + b) / 2);
+}
+
+inline char getMiddleDigit(char a, char b) {
+    return static_cast<char>((a + b) / 2);
+}
+
+// find the middle position i.e. find the middle marble in a triple sidestep
+inline std::string generateNewPos(const std::string& str1, const std::string& str2) {
+    // extract the row and col
+    char letter1 = str1[0];
+    char digit1 = str1[1];
+    char letter2 = str2[0];
+    char digit2 = str2[1];
+
+    // find new row
+    char newLetter;
+    if (letter1 == letter2) {
+        newLetter = letter1;
+    } else {
+        newLetter = getMiddleLetter(letter1, letter2);
+    }
+
+    // find new col
+    char newDigit;
+    if (digit1 == digit2) {
+        newDigit = digit1;
+    } else {
+        newDigit = getMiddleDigit(digit1, digit2);
+    }
+
+    std::string result;
+    result += newLetter;
+    result += newDigit;
+
+    return result;
+}
+
+
+// calculate new positions based on the direction
+template <typename BoardMap>
+inline std::string movePosition(BoardMap& boardState, const std::string& pos, const std::string& direction) {
+    char col = pos[0];
+    int row = std::stoi(pos.substr(1));
+
+    // move the position based on the direction
+    if (direction == "NE") {
+        col++;
+        row++;
+    } else if (direction == "E") {
+        row++;
+    } else if (direction == "SE") {
+        col--;
+    } else if (direction == "SW") {
+        col--;
+        row--;
+    } else if (direction == "W") {
+        row--;
+    } else if (direction == "NW") {
+        col++;
+    }
+    std:: string newPos = std::string(1, col) + std::to_string(row);
+
+    // return if valid, delete from board if not
+    if (isValidPosition(newPos)) {
+        return newPos;
+    }
+    boardState.erase(newPos);
+    return "";
+}
+
+template <typename BoardMap>
+inline bool arePositionsNotOneMoveAway(BoardMap& boardState, const std::string& pos1, const std::string& pos2) {
+    // Try all possible move directions
+    static const std::vector<std::string> directions = {"NE", "E", "SE", "SW", "W", "NW"};
+
+    for (const std::string& direction : directions) {
+        // Calculate the position from pos1 based on the current direction
+        std::string newPos = movePosition(boardState, pos1, direction);
+
+        // If the new position is the same as pos2, then they are within one move of each other
+        if (newPos == pos2) {
+            return false;
+        }
+    }
+
+    // if none of the directions lead to pos2, they are not within one move
+    return true;
+}
+
+
+
+// BoardMap is an unordered_map from position to colour ('b'/'w'), with any allocator
+template <typename BoardMap>
+inline void applyMove(BoardMap& boardState, const std::string& move) {
+    TRACE_SCOPE("applyMove");
+    // Apply move logic
+
+    if (char moveType = move[0]; moveType == 'i') {
+        std::string position = move.substr(1, 2);
+        std::string direction = move.substr(3);
+        char color = boardState[position];
+
+        // calculate the new position based on the move direction
+        std::string newPos = movePosition(boardState, position, direction);
+
+        // if new position is empty, simple move
+        if (boardState.find(newPos) == boardState.end()) {
+            boardState.erase(position);
+            boardState[newPos] = color;
+            return;
+        }
+
+        // Position is occupied - attempt to push
+        std::vector<std::pair<std::string, char>> toMove;
+        std::string currentPos = position;
+        std::string nextPos = newPos;
+
+        // Collect all occupied positions in the push chain
+        while (boardState.find(nextPos) != boardState.end()) {
+            toMove.emplace_back(currentPos, boardState[currentPos]);
+            currentPos = nextPos;
+            nextPos = movePosition(boardState, currentPos, direction);
+        }
+
+        // Add the final empty position to the chain
+        toMove.emplace_back(currentPos, boardState[currentPos]);
+        std::string finalEmptyPos = nextPos;  // Where the last marble will go
+
+        // Sift all marbles forward
+        for (size_t i = toMove.size() - 1; i > 0; --i) {
+            boardState[toMove[i].first] = toMove[i - 1].second;
+        }
+        // Place the last marble in the empty pos
+        boardState[finalEmptyPos] = toMove[toMove.size() - 1].second;
+        // Place the original moving marble
+        boardState[toMove[0].first] = color;
+
+        // Erase original position if we actually pushed
+        if (toMove.size() > 1) {
+            boardState.erase(position);
+        }
+    }
+    else if (moveType == 's') {
+            // sidestep move: extract positions and direction
+            std::string position1 = move.substr(1, 2);
+            std::string position2 = move.substr(3, 2);
+            std::string direction = move.substr(5);
+            // std::cout << "Move Type: " << moveType << ", Position 1: " << position1 << ", Position 2: " << position2 << ", Direction: " << direction << std::endl;
+            char color1 = boardState[position1];
+            char color2 = boardState[position2];
+
+            // calculate new positions based on direction for both positions
+            std::string newPos1 = movePosition(boardState, position1, direction);  // Move position1
+            std::string newPos2 = movePosition(boardState, position2, direction);  // Move position2
+
+
+            // remove old positions from the board
+            boardState.erase(position1);
+            boardState.erase(position2);
+
+            // add the new positions with their colors
+            boardState[newPos1] = color1;
+            boardState[newPos2] = color2;
+
+            if (arePositionsNotOneMoveAway(boardState, position1, position2)) {
+                std::string middlePos = generateNewPos(position1, position2);
+                char color3 = boardState[middlePos];
+                std::string newPos3 = movePosition(boardState, middlePos, direction);
+                boardState.erase(middlePos);
+                boardState[newPos3] = color3;
+            }
+        }
+}
+
+
+
+
+
+
+
+inline std::unordered_map<std::string, char> parseBoardFromString(const std::string& boardString) {
+    TRACE_SCOPE("parseBoardFromString");
+    std::unordered_map<std::string, char> boardState;
+    size_t start = 0;
+
+    while (start < boardString.size()) {
+        size_t end = boardString.find(',', start);
+        if (end == std::string::npos) {
+            end = boardString.size();
+        }
+        if (end > start) {
+            // the color is the last character, the position is everything before it
+            boardState[boardString.substr(start, end - start - 1)] = boardString[end - 1];
+        }
+        start = end + 1;
+    }
+
+    return boardState;  // Return by value
+}
+
+
+
+
+// helper function to convert the board state to string format for file output
+inline std::string boardToString(const std::unordered_map<std::string, char>& boardState) {
+    TRACE_SCOPE("boardToString");
+    std::string result;
+    for (const auto& [pos, color] : boardState) {
+        result += pos;
+        result += color;
+        result += ',';
+    }
+    if (!result.empty()) result.pop_back();
+    return result;
+}
+
+inline std::vector<std::string> generateBoardStates(const AbaloneBoard& initialBoard, const std::vector<std::string>& moves) {
+    std::vector<std::string> boardStates;
+    auto initialBoardState = parseBoardFromString(initialBoard.boardToString());
+
+    for (const std::string& move : moves) {
+        // Create a fresh copy of the initial board state for each move
+        auto boardState = initialBoardState;
+
+        // Apply the move
+        applyMove(boardState, move);
+
+        // Convert to string and clean it
+        std::string boardStr = boardToString(boardState);
+        boardStr = removeSingleCharValues(boardStr);
+        boardStates.push_back(boardStr);
+    }
+
+    return boardStates;
+}
+
+
+// The terms of the evaluation (h1 to h10 below), each from the point of view of the side being
+// evaluated. The score is the weighted sum of the terms; a term with weight 0 is switched off.
+// h1 to h5 measure the side being evaluated; the positional terms h6 to h10 are the side's count
+// minus the opponent's:
+//   EDGE        marbles on the outer ring of the board
+//   EXPOSED     marbles the other side could push off the board with its next move
+//   PAIRS       two marbles in a row, counted once per axis
+//   TRIPLES     three marbles in a row, counted once per axis
+//   MOBILITY    single marble steps to an empty cell
+enum EvalFeature {
+    CENTER_PROXIMITY, COHESION, MARBLES_ON_BOARD, PUSHED_OFF, LOST,
+    EDGE, EXPOSED, PAIRS, TRIPLES, MOBILITY,
+    EVAL_FEATURE_COUNT
+};
+
+// names used in weights files and on the command line (see eval_weights.h)
+const std::array<const char*, EVAL_FEATURE_COUNT> EVAL_FEATURE_NAMES = {
+    "centerProximity", "cohesion", "marblesOnBoard", "pushedOff", "lost",
+    "edge", "exposed", "pairs", "triples", "mobility"};
+
+using EvalWeights = std::array<int, EVAL_FEATURE_COUNT>;
+
+// h3 (marbles on board) and the positional terms h6 to h10 are off by default; switch the
+// positional terms on with --eval or a weights file, e.g. --eval edge=-20,exposed=-60,pairs=10,triples=10,mobility=3
+const EvalWeights DEFAULT_EVAL_WEIGHTS = {15, 65, 0, 200, 150, 0, 0, 0, 0, 0};
+
+// the weights in use (see setEvalWeights below)
+inline const EvalWeights& evalWeights();
+
+inline int marblesOnBoard(const std::string& boardState, CellState player) {
+    int playerCount = 0;
+    int opponentCount = 0;
+    char a;
+
+
+    char playerChar = (player == CellState::BLACK) ? 'b' : 'w';  // Player's marble character
+    char opponentChar = (player == CellState::BLACK) ? 'w' : 'b';  // Opponent's marble character
+
+    // Loop through the board state (assuming two characters per marble, e.g., C5b)
+    for (size_t i = 0; i < boardState.size(); i += 4) {
+        a = boardState[i+2];
+        if (boardState[i + 2] == playerChar) {
+            playerCount++;
+        } else //if
+        // (boardState[i + 1] == opponentChar)
+            {
+            opponentCount++;
+        }
+    }
+    // std::cout << playerCount << "\n";
+    // std::cout << opponentCount << "\n";
+    return playerCount - opponentCount;  // Return the difference: positive if player's marbles are more
+}
+
+
+
+inline int calculateDistance(const std::string& pos1, const std::string& pos2) {
+    // Hex distance between the cells
+    return cellDistance(cellIndex(pos1), cellIndex(pos2));
+}
+
+inline int centerProximity(const std::string& boardState, CellState player) {std::string center = "E5";  // Center of the board
+    int totalDistance = 0;
+    int count = 0;
+    char playerChar = (player == CellState::BLACK) ? 'b' : 'w';  // Set player piece ('b' or 'w')
+    char a;
+    for (size_t i = 0; i < boardState.size(); i += 4) {
+         a = boardState[i+2]; // Assuming each position in the board is represented by 2 characters
+        if (a == playerChar) {  // Check if the second character matches the player's piece
+            std::string pos = boardState.substr(i, 2);  // Get the position and piece
+            totalDistance += calculateDistance(pos, center);
+            count++;
+        }
+    }
+
+    if (count == 0) return 0;
+    return totalDistance / count; // Average distance from center
+}
+
+
+inline int cohesion(const std::string& boardState, CellState player) {
+    char playerChar = (player == CellState::BLACK) ? 'b' : 'w';
+    std::vector<std::string> positions;
+
+    // Extract all positions of the player's marbles
+    for (size_t i = 0; i < boardState.size(); i += 4) {
+        if (boardState[i+2] == playerChar) {
+            positions.push_back(boardState.substr(i, 2));
+        }
+    }
+
+    // Calculate average distance between all marbles
+    int totalDistance = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        for (size_t j = i+1; j < positions.size(); ++j) {
+            totalDistance += calculateDistance(positions[i], positions[j]);
+        }
+    }
+
+    return (positions.empty()) ? 0 : totalDistance / positions.size();
+}
+
+
+inline int opponentMarblesPushed(const std::string& boardState, CellState player) {
+    char opponentChar = (player == CellState::BLACK) ? 'w' : 'b';
+    int opponentMarbles = std::count(boardState.begin(), boardState.end(), opponentChar);
+    return 14 - opponentMarbles;  // Starts at 14 (max marbles), decreases as opponent loses marbles
+}
+
+
+// the positional terms (h6 to h10) of one side, cell by cell on the board string;
+// evaluationFeatures computes the same with bitboards
+struct PositionalCounts {
+    int edge = 0;
+    int exposed = 0;
+    int pairs = 0;
+    int triples = 0;
+    int mobility = 0;
+};
+
+inline PositionalCounts positionalCounts(const std::unordered_map<std::string, char>& boardState, char playerChar) {
+    const char opponentChar = (playerChar == 'b') ? 'w' : 'b';
+    auto colorAt = [&boardState](const std::string& pos) {
+        const auto cell = boardState.find(pos);
+        return (cell == boardState.end()) ? ' ' : cell->second;
+    };
+    auto next = [](const std::string& pos, int dir) {
+        return pos.empty() ? pos : AbaloneBoard::getAdjacentPosition(pos, directions[dir]);
+    };
+
+    PositionalCounts counts;
+    for (const auto& [pos, color] : boardState) {
+        if (color != playerChar) {
+            continue;
+        }
+        bool onEdge = false;
+        bool exposed = false;
+        for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+            const std::string target = next(pos, dir);
+            if (!target.empty()) {
+                counts.mobility += (colorAt(target) == ' ') ? 1 : 0;
+                continue;
+            }
+            onEdge = true;
+            // could a longer opponent line behind this marble push it off towards dir?
+            const int back = DIRECTION_COUNT - 1 - dir;
+            int ownLine = 1;
+            std::string behind = next(pos, back);
+            if (colorAt(behind) == playerChar) {
+                ownLine++;
+                behind = next(behind, back);
+            }
+            int opponentLine = 0;
+            while (opponentLine < 3 && !behind.empty() && colorAt(behind) == opponentChar) {
+                opponentLine++;
+                behind = next(behind, back);
+            }
+            exposed = exposed || opponentLine > ownLine;
+        }
+        counts.edge += onEdge ? 1 : 0;
+        counts.exposed += exposed ? 1 : 0;
+        // lines starting here along the NE, NW and E axes
+        for (int dir = 0; dir < 3; dir++) {
+            const std::string second = next(pos, dir);
+            if (!second.empty() && colorAt(second) == playerChar) {
+                counts.pairs++;
+                const std::string third = next(second, dir);
+                counts.triples += (!third.empty() && colorAt(third) == playerChar) ? 1 : 0;
+            }
+        }
+    }
+    return counts;
+}
+
+// the terms of the evaluation (see EvalFeature) from the board string, one helper per term;
+// evaluationFeatures computes the same from the cells, and movefuzz checks that they agree
+inline std::array<int, EVAL_FEATURE_COUNT> boardStringFeatures(const std::string& boardState, CellState player) {
+    char playerChar = (player == CellState::BLACK) ? 'b' : 'w';
+
+    std::array<int, EVAL_FEATURE_COUNT> features{};
+    features[CENTER_PROXIMITY] = centerProximity(boardState, player);
+    features[COHESION] = cohesion(boardState, player);
+    features[MARBLES_ON_BOARD] = marblesOnBoard(boardState, player);
+    features[PUSHED_OFF] = opponentMarblesPushed(boardState, player);
+    features[LOST] = -(14 - static_cast<int>(std::count(boardState.begin(), boardState.end(), playerChar)));
+
+    // h6 to h10: the positional terms, ours minus the opponent's
+    const auto cells = parseBoardFromString(boardState);
+    const PositionalCounts own = positionalCounts(cells, playerChar);
+    const PositionalCounts opponent = positionalCounts(cells, (playerChar == 'b') ? 'w' : 'b');
+    features[EDGE] = own.edge - opponent.edge;
+    features[EXPOSED] = own.exposed - opponent.exposed;
+    features[PAIRS] = own.pairs - opponent.pairs;
+    features[TRIPLES] = own.triples - opponent.triples;
+    features[MOBILITY] = own.mobility - opponent.mobility;
+    return features;
+}
+
+inline int evaluateBoard(const std::string& boardState, CellState player) {
+    TRACE_SCOPE("evaluateBoard");
+    const std::array<int, EVAL_FEATURE_COUNT> features = boardStringFeatures(boardState, player);
+    const EvalWeights& weights = evalWeights();
+    int score = 0;
+    for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+        score += weights[feature] * features[feature];
+    }
+    return score;
+}
+
+
+// Features that share their work are switched on and off together: the evaluator is specialised
+// on the groups with a non-zero weight. Marble counts (h3 to h5) are always computed.
+enum EvalGroup { CENTER_GROUP, COHESION_GROUP, EDGE_GROUP, EXPOSED_GROUP, FORMATION_GROUP, MOBILITY_GROUP, EVAL_GROUP_COUNT };
+
+constexpr int NO_EVAL_GROUP = -1;
+
+constexpr std::array<int, EVAL_FEATURE_COUNT> EVAL_FEATURE_GROUP = {
+    CENTER_GROUP, COHESION_GROUP, NO_EVAL_GROUP, NO_EVAL_GROUP, NO_EVAL_GROUP,
+    EDGE_GROUP, EXPOSED_GROUP, FORMATION_GROUP, FORMATION_GROUP, MOBILITY_GROUP};
+
+constexpr unsigned ALL_EVAL_GROUPS = (1u << EVAL_GROUP_COUNT) - 1;
+
+// the cells at each cellDistance from E5
+constexpr std::array<CellMask, 5> CENTER_RINGS = [] {
+    std::array<CellMask, 5> rings{};
+    for (int index = 0; index < NUM_CELLS; index++) {
+        rings[cellDistance(index, 30)] |= CellMask(1) << index;  // cell 30 is E5
+    }
+    return rings;
+}();
+
+// sum of |line a - line b| over all pairs of cells, from the number of cells on each line
+template <size_t Lines>
+inline int lineGapSum(const std::array<int, Lines>& cellsOnLine) {
+    int total = 0;
+    int cellsBefore = 0;
+    int linesBefore = 0;  // sum of the lines of the cells before
+    for (int line = 0; line < static_cast<int>(Lines); line++) {
+        total += cellsOnLine[line] * (line * cellsBefore - linesBefore);
+        cellsBefore += cellsOnLine[line];
+        linesBefore += cellsOnLine[line] * line;
+    }
+    return total;
+}
+
+// Sum of cellDistance over all pairs of cells in a set, in one pass over the cells rather than
+// one step per pair (cohesion). The hex distance is half the sum of the gaps along the board's
+// three axes (rows, digits and row - digit), and the gaps along an axis follow from how many
+// cells lie on each of its 9 lines.
+inline int pairDistanceSum(CellMask cells) {
+    std::array<int, 9> rows{};
+    std::array<int, 9> digits{};  // digit - 1
+    std::array<int, 9> skews{};   // row - digit + 5
+    for (CellMask rest = cells; rest != 0; rest &= rest - 1) {
+        const int cell = lowestCell(rest);
+        rows[boardGeometry.row[cell]]++;
+        digits[boardGeometry.digit[cell] - 1]++;
+        skews[boardGeometry.row[cell] - boardGeometry.digit[cell] + 5]++;
+    }
+    return (lineGapSum(rows) + lineGapSum(digits) + lineGapSum(skews)) / 2;
+}
+
+// The marbles of victim that attacker could push off the board with its next move: for each
+// direction, victim marbles on the edge facing it with a longer attacker line right behind.
+inline CellMask exposedMarbles(CellMask victim, CellMask attacker) {
+    CellMask exposed = 0;
+    forEachDirection([&](auto dir) {
+        constexpr int Dir = decltype(dir)::value;
+        const CellMask front = victim & directionShifts[Dir].edge;
+        if (front == 0) {
+            return;
+        }
+        // cells with an attacker marble 1, 2, ... steps behind them (against Dir)
+        const CellMask behind1 = shiftCells<Dir>(attacker);
+        const CellMask behind2 = shiftCells<Dir>(behind1);
+        exposed |= front & behind1 & behind2;  // 2 or 3 on 1
+        const CellMask pairs = front & shiftCells<Dir>(victim) & behind2;
+        if (pairs != 0) {
+            const CellMask behind3 = shiftCells<Dir>(behind2);
+            exposed |= pairs & behind3 & shiftCells<Dir>(behind3);  // 3 on 2
+        }
+    });
+    return exposed;
+}
+
+// lines of two and of three marbles of a set, counted once per axis (NE, NW and E)
+inline std::pair<int, int> formations(CellMask marbles) {
+    int pairs = 0;
+    int triples = 0;
+    forEachDirection<3>([&](auto dir) {
+        constexpr int Dir = decltype(dir)::value;
+        const CellMask pairEnds = marbles & shiftCells<Dir>(marbles);  // marbles with one of the set behind
+        pairs += popCount(pairEnds);
+        triples += popCount(pairEnds & shiftCells<Dir>(pairEnds));
+    });
+    return {pairs, triples};
+}
+
+// single marble steps from a set of marbles to an empty cell
+inline int mobility(CellMask marbles, CellMask empty) {
+    int steps = 0;
+    forEachDirection([&](auto dir) {
+        steps += popCount(shiftCells<decltype(dir)::value>(marbles) & empty);
+    });
+    return steps;
+}
+
+// the terms of evaluateBoard for a board rather than its string, from Us's point of view,
+// computed straight from the cells. Only the features in Groups (a bit per EvalGroup) and the
+// marble counts are computed, the others are 0.
+template <CellState Us, unsigned Groups = ALL_EVAL_GROUPS>
+inline std::array<int, EVAL_FEATURE_COUNT> evaluationFeatures(const AbaloneBoard& board) {
+    constexpr CellState Them = opponentOf(Us);
+    constexpr auto has = [](EvalGroup group) { return (Groups >> group) & 1u; };
+
+    // both sides' marbles as bitboards, built without branching on the cells
+    CellMask own = 0;
+    CellMask opponent = 0;
+    const auto& cells = board.getBoard();
+    for (int index = 0; index < NUM_CELLS; index++) {
+        own |= CellMask(cells[index].state == Us) << index;
+        opponent |= CellMask(cells[index].state == Them) << index;
+    }
+    const int ownCount = popCount(own);
+    const int opponentCount = popCount(opponent);
+
+    int totalCenterDistance = 0;
+    if constexpr (has(CENTER_GROUP)) {
+        for (int distance = 1; distance < static_cast<int>(CENTER_RINGS.size()); distance++) {
+            totalCenterDistance += distance * popCount(own & CENTER_RINGS[distance]);
+        }
+    }
+    int totalPairDistance = 0;
+    if constexpr (has(COHESION_GROUP)) {
+        totalPairDistance = pairDistanceSum(own);
+    }
+
+    std::array<int, EVAL_FEATURE_COUNT> features{};
+    features[CENTER_PROXIMITY] = ownCount ? totalCenterDistance / ownCount : 0;
+    features[COHESION] = ownCount ? totalPairDistance / ownCount : 0;
+    features[MARBLES_ON_BOARD] = ownCount - opponentCount;
+    features[PUSHED_OFF] = 14 - opponentCount;  // opponent marbles pushed off
+    features[LOST] = -(14 - ownCount);          // own marbles lost
+
+    // the positional terms, as bitboard operations on both sides' marbles
+    if constexpr (has(EDGE_GROUP)) {
+        features[EDGE] = popCount(own & EDGE_CELLS) - popCount(opponent & EDGE_CELLS);
+    }
+    if constexpr (has(EXPOSED_GROUP)) {
+        features[EXPOSED] = popCount(exposedMarbles(own, opponent)) - popCount(exposedMarbles(opponent, own));
+    }
+    if constexpr (has(FORMATION_GROUP)) {
+        const auto [ownPairs, ownTriples] = formations(own);
+        const auto [opponentPairs, opponentTriples] = formations(opponent);
+        features[PAIRS] = ownPairs - opponentPairs;
+        features[TRIPLES] = ownTriples - opponentTriples;
+    }
+    if constexpr (has(MOBILITY_GROUP)) {
+        const CellMask empty = ALL_CELLS & ~(own | opponent);
+        features[MOBILITY] = mobility(own, empty) - mobility(opponent, empty);
+    }
+    return features;
+}
+
+// evaluation with the features in Groups and the weights given, from Us's point of view
+template <CellState Us, unsigned Groups>
+int evaluateFeatures(const AbaloneBoard& board, const EvalWeights& weights) {
+    const std::array<int, EVAL_FEATURE_COUNT> features = evaluationFeatures<Us, Groups>(board);
+    int score = 0;
+    for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+        score += weights[feature] * features[feature];
+    }
+    return score;
+}
+
+using Evaluator = int (*)(const AbaloneBoard&, const EvalWeights&);
+
+// evaluateFeatures for every set of groups, indexed by the set
+template <CellState Us, unsigned... Groups>
+constexpr std::array<Evaluator, sizeof...(Groups)> makeEvaluators(std::integer_sequence<unsigned, Groups...>) {
+    return {&evaluateFeatures<Us, Groups>...};
+}
+
+template <CellState Us>
+constexpr std::array<Evaluator, ALL_EVAL_GROUPS + 1> EVALUATORS =
+    makeEvaluators<Us>(std::make_integer_sequence<unsigned, ALL_EVAL_GROUPS + 1>());
+
+// The evaluation configuration, compiled: the weights, and for each side the evaluator that
+// computes exactly the groups of features with a non-zero weight. Evaluating a leaf is one call
+// through a pointer chosen at startup; switched-off groups cost nothing and nothing is tested
+// per leaf.
+struct CompiledEval {
+    EvalWeights weights{};
+    Evaluator black = nullptr;
+    Evaluator white = nullptr;
+
+    explicit CompiledEval(const EvalWeights& evalWeights) : weights(evalWeights) {
+        unsigned groups = 0;
+        for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+            if (weights[feature] != 0 && EVAL_FEATURE_GROUP[feature] != NO_EVAL_GROUP) {
+                groups |= 1u << EVAL_FEATURE_GROUP[feature];
+            }
+        }
+        black = EVALUATORS<CellState::BLACK>[groups];
+        white = EVALUATORS<CellState::WHITE>[groups];
+    }
+};
+
+inline CompiledEval compiledEval(DEFAULT_EVAL_WEIGHTS);
+
+// configure the evaluation; call it at startup (trial --weights, --eval), before any search
+inline void setEvalWeights(const EvalWeights& weights) {
+    compiledEval = CompiledEval(weights);
+}
+
+inline const EvalWeights& evalWeights() {
+    return compiledEval.weights;
+}
+
+// evaluateBoard for a board rather than its string, from Us's point of view (the search calls
+// this at every leaf)
+template <CellState Us>
+inline int evaluatePosition(const AbaloneBoard& board) {
+    TRACE_SCOPE("evaluateBoard");
+    if constexpr (Us == CellState::BLACK) {
+        return compiledEval.black(board, compiledEval.weights);
+    } else {
+        return compiledEval.white(board, compiledEval.weights);
+    }
+}
+
+// starting layouts offered by the game loop (1 = Default, 2 = German, 3 = Belgian Daisy)
+inline const std::string& layoutString(int layoutChoice) {
+    static const std::string layouts[] = {
+        "I5w,I6w,I7w,I8w,I9w,H4w,H5w,H6w,H7w,H8w,H9w,G5w,G6w,G7w,A1b,A2b,A3b,A4b,A5b,B1b,B2b,B3b,B4b,B5b,B6b,C3b,C4b,C5b",
+        "H4w,H5w,G3w,G4w,G5w,F3w,F4w,H8b,H9b,G7b,G8b,G9b,F7b,F8b,D2b,D3b,C1b,C2b,C3b,B1b,B2b,D6w,D7w,C5w,C6w,C7w,B5w,B6w",
+        "I5w,I6w,H4w,H5w,H6w,G4w,G5w,I8b,I9b,H7b,H8b,H9b,G7b,G8b,C2b,C3b,B1b,B2b,B3b,A1b,A2b,C5w,C6w,B4w,B5w,B6w,A4w,A5w"
+    };
+    static const std::string empty;
+    return (layoutChoice >= 1 && layoutChoice <= 3) ? layouts[layoutChoice - 1] : empty;
+}
+
+// marbles a side starts with; no game position has more, and MAX_LEGAL_MOVES relies on it
+constexpr int MARBLES_PER_SIDE = 14;
+
+// does each side have at most MARBLES_PER_SIDE marbles? Boards from outside (input files,
+// the protocol, the server) must, or the move list can't hold every legal move.
+inline bool hasValidMarbleCounts(const AbaloneBoard& board) {
+    int black = 0;
+    int white = 0;
+    for (const Cell& cell : board.getBoard()) {
+        black += (cell.state == CellState::BLACK) ? 1 : 0;
+        white += (cell.state == CellState::WHITE) ? 1 : 0;
+    }
+    return black <= MARBLES_PER_SIDE && white <= MARBLES_PER_SIDE;
+}
+
+// hash a position together with the side to move
+inline uint64_t hashBoard(const AbaloneBoard& board, CellState toMove) {
+    return board.positionKey() ^ ((toMove == CellState::BLACK) ? zobristKeys.blackToMove : 0);
+}
+
+// a position on the board for the third time is a draw
+constexpr int REPETITION_DRAW = 3;
+
+// The positions of a game (hashBoard keys) since the last push-off, for repetition draws and
+// for the search (SearchParams::history). Nothing before a push-off can come back: marbles
+// only ever leave the board.
+class GameHistory {
+    std::vector<uint64_t> keys;  // oldest first, the current position last
+    int marbles = 0;
+
+    static int marbleCount(const AbaloneBoard& board) {
+        int count = 0;
+        for (const Cell& cell : board.getBoard()) {
+            count += (cell.state != CellState::EMPTY) ? 1 : 0;
+        }
+        return count;
+    }
+
+public:
+    void reset(const AbaloneBoard& board, CellState toMove) {
+        keys.assign(1, hashBoard(board, toMove));
+        marbles = marbleCount(board);
+    }
+
+    // the position after a move
+    void add(const AbaloneBoard& board, CellState toMove) {
+        const int count = marbleCount(board);
+        if (count != marbles) {
+            keys.clear();
+            marbles = count;
+        }
+        keys.push_back(hashBoard(board, toMove));
+    }
+
+    // how often the current position has been on the board, this time included
+    [[nodiscard]] int occurrences() const {
+        return keys.empty() ? 0 : static_cast<int>(std::count(keys.begin(), keys.end(), keys.back()));
+    }
+
+    [[nodiscard]] const std::vector<uint64_t>& positions() const {
+        return keys;
+    }
+};
+
+
+// result of a root search: score from Black's point of view, best move, and the deepest completed iteration
+struct SearchResult {
+    int score = 0;
+    std::string move;
+    int depth = 0;
+};
+
+// one completed iteration of iterative deepening
+struct IterationStats {
+    int depth = 0;
+    int64_t microseconds = 0;   // time spent on this iteration
+    uint64_t nodes = 0;         // nodes searched by this iteration
+    int score = 0;
+    std::string move;
+};
+
+// Counters filled in by the search when SearchParams::stats is set. All search threads add
+// to the same counters, so with several threads the numbers cover the helpers' work too.
+struct SearchStats {
+    static const int MAX_PLY = 32;      // deeper plies are counted in the last slot
+
+    std::atomic<uint64_t> nodes{0};             // minimax and quiescence nodes
+    std::atomic<uint64_t> quiescenceNodes{0};
+    std::atomic<uint64_t> evaluations{0};       // calls to evaluateBoard at leaves
+    std::atomic<uint64_t> ttProbes{0};
+    std::atomic<uint64_t> ttHits{0};            // an entry for the position was found
+    std::atomic<uint64_t> ttCutoffs{0};         // ... and its score could be returned directly
+    std::atomic<uint64_t> ttStores{0};
+    std::atomic<uint64_t> ttCollisions{0};      // stores that replaced another position
+    std::atomic<uint64_t> betaCutoffs{0};
+    std::atomic<uint64_t> firstMoveCutoffs{0};  // beta cutoffs by the first move searched
+    std::atomic<uint64_t> nullMoveCutoffs{0};
+    std::atomic<uint64_t> lmrResearches{0};     // reduced searches that had to be repeated at full depth
+    std::atomic<uint64_t> repetitions{0};       // nodes scored as a draw by repetition
+
+    // branching per ply from the root, counted at nodes that reach the move loop
+    std::array<std::atomic<uint64_t>, MAX_PLY> plyNodes{};
+    std::array<std::atomic<uint64_t>, MAX_PLY> plyLegalMoves{};
+    std::array<std::atomic<uint64_t>, MAX_PLY> plySearchedMoves{};
+
+    // written by searchBestMove only, after each completed iteration
+    std::vector<IterationStats> iterations;
+
+    void reset() {
+        for (std::atomic<uint64_t>* counter : {&nodes, &quiescenceNodes, &evaluations, &ttProbes, &ttHits,
+                                               &ttCutoffs, &ttStores, &ttCollisions, &betaCutoffs,
+                                               &firstMoveCutoffs, &nullMoveCutoffs, &lmrResearches, &repetitions}) {
+            *counter = 0;
+        }
+        for (int ply = 0; ply < MAX_PLY; ply++) {
+            plyNodes[ply] = 0;
+            plyLegalMoves[ply] = 0;
+            plySearchedMoves[ply] = 0;
+        }
+        iterations.clear();
+    }
+
+    // human-readable report, one topic per line
+    [[nodiscard]] std::string summary() const {
+        auto percent = [](uint64_t part, uint64_t whole) {
+            char buffer[16];
+            std::snprintf(buffer, sizeof(buffer), "%.1f%%", whole ? 100.0 * part / whole : 0.0);
+            return std::string(buffer);
+        };
+        std::string text = "Search: " + std::to_string(nodes) + " nodes (" + std::to_string(quiescenceNodes) +
+                           " quiescence), " + std::to_string(evaluations) + " evaluations\n";
+        text += "TT: " + std::to_string(ttProbes) + " probes, " + std::to_string(ttHits) + " hits (" +
+                percent(ttHits, ttProbes) + "), " + std::to_string(ttCutoffs) + " cutoffs, " +
+                std::to_string(ttStores) + " stores, " + std::to_string(ttCollisions) + " collisions\n";
+        text += "Cutoffs: " + std::to_string(betaCutoffs) + " beta, " + std::to_string(firstMoveCutoffs) +
+                " on the first move (" + percent(firstMoveCutoffs, betaCutoffs) + "), " +
+                std::to_string(nullMoveCutoffs) + " null move, " + std::to_string(lmrResearches) +
+                " LMR re-searches, " + std::to_string(repetitions) + " repetitions\n";
+        text += "Branching (legal/searched):";
+        for (int ply = 0; ply < MAX_PLY && plyNodes[ply] > 0; ply++) {
+            char buffer[48];
+            std::snprintf(buffer, sizeof(buffer), " %d: %.1f/%.1f", ply,
+                          static_cast<double>(plyLegalMoves[ply]) / plyNodes[ply],
+                          static_cast<double>(plySearchedMoves[ply]) / plyNodes[ply]);
+            text += buffer;
+        }
+        text += "\nIterations:";
+        for (const IterationStats& iteration : iterations) {
+            text += " d" + std::to_string(iteration.depth) + " " + std::to_string(iteration.microseconds / 1000) +
+                    " ms";
+        }
+        return text;
+    }
+
+    // the same numbers as one JSON object
+    [[nodiscard]] std::string toJson() const {
+        std::string json = "{\"nodes\":" + std::to_string(nodes) +
+                           ",\"quiescenceNodes\":" + std::to_string(quiescenceNodes) +
+                           ",\"evaluations\":" + std::to_string(evaluations) +
+                           ",\"tt\":{\"probes\":" + std::to_string(ttProbes) +
+                           ",\"hits\":" + std::to_string(ttHits) +
+                           ",\"cutoffs\":" + std::to_string(ttCutoffs) +
+                           ",\"stores\":" + std::to_string(ttStores) +
+                           ",\"collisions\":" + std::to_string(ttCollisions) + "}" +
+                           ",\"betaCutoffs\":" + std::to_string(betaCutoffs) +
+                           ",\"firstMoveCutoffs\":" + std::to_string(firstMoveCutoffs) +
+                           ",\"nullMoveCutoffs\":" + std::to_string(nullMoveCutoffs) +
+                           ",\"lmrResearches\":" + std::to_string(lmrResearches) +
+                           ",\"repetitions\":" + std::to_string(repetitions) + ",\"plies\":[";
+        for (int ply = 0; ply < MAX_PLY && plyNodes[ply] > 0; ply++) {
+            json += std::string(ply ? "," : "") + "{\"ply\":" + std::to_string(ply) +
+                    ",\"nodes\":" + std::to_string(plyNodes[ply]) +
+                    ",\"legalMoves\":" + std::to_string(plyLegalMoves[ply]) +
+                    ",\"searchedMoves\":" + std::to_string(plySearchedMoves[ply]) + "}";
+        }
+        json += "],\"iterations\":[";
+        for (size_t i = 0; i < iterations.size(); i++) {
+            json += std::string(i ? "," : "") + "{\"depth\":" + std::to_string(iterations[i].depth) +
+                    ",\"microseconds\":" + std::to_string(iterations[i].microseconds) +
+                    ",\"nodes\":" + std::to_string(iterations[i].nodes) +
+                    ",\"score\":" + std::to_string(iterations[i].score) +
+                    ",\"move\":\"" + iterations[i].move + "\"}";
+        }
+        return json + "]}";
+    }
+};
+
+// tunable search settings, passed down through minimax
+struct SearchParams {
+    int depth = 3;                      // nominal search depth in plies
+    int quiescenceDepth = 4;            // maximum push plies searched past the nominal depth
+
+    // null-move pruning: let the opponent move twice; if we still fail high, cut off
+    bool nullMove = true;
+    int nullMoveReduction = 2;          // R: the null-move search is depth - 1 - R
+    int nullMoveMinDepth = 3;           // only try a null move with at least this much depth left
+    bool nullMoveVerification = true;   // confirm a null-move cutoff with a reduced normal search
+
+    // late move reductions for quiet moves ordered late
+    bool lateMoveReductions = true;
+    int lmrFullDepthMoves = 4;          // moves searched at full depth before reducing
+    int lmrMinDepth = 3;                // only reduce with at least this much depth left
+    int lmrReduction = 1;               // plies taken off a reduced search
+
+    // search threads; helpers search the same position and share results through the transposition table
+    int threads = 1;
+
+    // the game so far (GameHistory::positions, the root last), so the search sees repetitions
+    // of positions played before the root; without it only the search path is checked
+    const std::vector<uint64_t>* history = nullptr;
+    // how much worse than the position itself a repetition draw is for the side to move at the
+    // root; 0 scores a draw as even, a positive value makes the engine avoid draws
+    int contempt = 0;
+    // the side to move at the root, which contempt counts against; minimax fills it in when it
+    // is left EMPTY, so only the root call needs it
+    CellState rootSide = CellState::EMPTY;
+
+    // set by another thread to abandon the search; the last completed iteration is kept
+    const std::atomic<bool>* stop = nullptr;
+    // optional progress reporting: incremented for every node searched
+    std::atomic<uint64_t>* nodes = nullptr;
+    // optional progress reporting: called by searchBestMove after each completed iteration
+    std::function<void(const SearchResult&)> onIteration;
+    // optional instrumentation, filled in by the search (see SearchStats)
+    SearchStats* stats = nullptr;
+};
+
+inline bool searchStopped(const SearchParams& params) {
+    return params.stop && params.stop->load(std::memory_order_relaxed);
+}
+
+inline void countNode(const SearchParams& params) {
+    if (params.nodes) {
+        params.nodes->fetch_add(1, std::memory_order_relaxed);
+    }
+    if (params.stats) {
+        params.stats->nodes.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// add to one of the SearchStats counters, if statistics were requested
+inline void countStat(const SearchParams& params, std::atomic<uint64_t> SearchStats::*counter, uint64_t amount = 1) {
+    if (params.stats) {
+        (params.stats->*counter).fetch_add(amount, std::memory_order_relaxed);
+    }
+}
+
+// add to a per-ply SearchStats counter
+inline void countPlyStat(const SearchParams& params,
+                         std::array<std::atomic<uint64_t>, SearchStats::MAX_PLY> SearchStats::*counters, int ply,
+                         uint64_t amount = 1) {
+    if (params.stats) {
+        (params.stats->*counters)[std::min(ply, SearchStats::MAX_PLY - 1)].fetch_add(amount, std::memory_order_relaxed);
+    }
+}
+
+// how the stored score relates to the true value of the position
+enum class TTBound : uint8_t { EXACT, LOWER, UPPER };
+
+struct TTEntry {
+    uint64_t key = 0;     // hashBoard of the position and the side to move
+    int32_t score = 0;
+    int16_t depth = -1;   // -1: the slot is empty
+    TTBound bound = TTBound::EXACT;
+    uint8_t generation = 0;  // the search that stored it (see newSearch)
+    Move move;
+};
+
+// Transposition table shared by all search threads: a fixed array of entries, allocated once,
+// so storing a position never allocates. A position may go in any slot of its bucket; when the
+// bucket is full, the entry left over from an older search or, among those of the same search,
+// the shallowest one is replaced. Buckets are guarded by a set of locks so threads rarely wait
+// on each other.
+class TranspositionTable {
+    static const size_t BUCKET_SIZE = 4;
+    static const size_t LOCK_COUNT = 256;
+    static const size_t DEFAULT_ENTRIES = size_t{1} << 20;  // 24 MB
+
+    std::vector<TTEntry> entries;
+    size_t bucketMask = 0;
+    std::array<std::mutex, LOCK_COUNT> locks;
+    std::atomic<size_t> used{0};
+    std::atomic<uint8_t> generation{0};
+
+    [[nodiscard]] size_t bucketOf(uint64_t key) const {
+        return static_cast<size_t>(key) & bucketMask;
+    }
+
+public:
+    TranspositionTable() {
+        resize(DEFAULT_ENTRIES);
+    }
+
+    // room for about size entries (rounded down to a power of two, at least one bucket); the
+    // table is emptied. Call it when no search is running.
+    void resize(size_t size) {
+        size_t buckets = 1;
+        while (buckets * 2 * BUCKET_SIZE <= size) {
+            buckets *= 2;
+        }
+        entries.assign(buckets * BUCKET_SIZE, TTEntry());
+        entries.shrink_to_fit();
+        bucketMask = buckets - 1;
+        used = 0;
+    }
+
+    // copy the entry for key into entry; returns false if there is none
+    bool probe(uint64_t key, TTEntry& entry) {
+        TRACE_SCOPE("tt.probe");
+        const size_t bucket = bucketOf(key);
+        std::lock_guard<std::mutex> lock(locks[bucket % LOCK_COUNT]);
+        for (size_t slot = bucket * BUCKET_SIZE; slot < (bucket + 1) * BUCKET_SIZE; slot++) {
+            if (entries[slot].key == key && entries[slot].depth >= 0) {
+                entry = entries[slot];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // returns true if the position took the place of another one
+    bool store(uint64_t key, int score, int depth, const Move& move, TTBound bound) {
+        TRACE_SCOPE("tt.store");
+        const uint8_t current = generation.load(std::memory_order_relaxed);
+        const size_t bucket = bucketOf(key);
+        std::lock_guard<std::mutex> lock(locks[bucket % LOCK_COUNT]);
+        TTEntry* target = nullptr;
+        int targetWorth = INT_MAX;
+        for (size_t slot = bucket * BUCKET_SIZE; slot < (bucket + 1) * BUCKET_SIZE; slot++) {
+            TTEntry& candidate = entries[slot];
+            if (candidate.depth < 0 || candidate.key == key) {
+                target = &candidate;
+                break;
+            }
+            // entries of older searches go first, then the shallowest
+            const int age = static_cast<uint8_t>(current - candidate.generation);
+            const int worth = candidate.depth - 8 * age;
+            if (worth < targetWorth) {
+                target = &candidate;
+                targetWorth = worth;
+            }
+        }
+        const bool replaced = target->depth >= 0 && target->key != key;
+        if (target->depth < 0) {
+            used.fetch_add(1, std::memory_order_relaxed);
+        }
+        target->key = key;
+        target->score = score;
+        target->depth = static_cast<int16_t>(depth);
+        target->bound = bound;
+        target->generation = current;
+        target->move = move;
+        return replaced;
+    }
+
+    // a new search begins: what earlier searches stored is replaced first
+    void newSearch() {
+        generation.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void clear() {
+        for (std::mutex& mutex : locks) {
+            mutex.lock();
+        }
+        std::fill(entries.begin(), entries.end(), TTEntry());
+        used = 0;
+        for (std::mutex& mutex : locks) {
+            mutex.unlock();
+        }
+    }
+
+    // number of positions stored
+    size_t size() const {
+        return used.load(std::memory_order_relaxed);
+    }
+
+    // number of positions the table can hold
+    size_t capacity() const {
+        return entries.size();
+    }
+};
+
+// Global transposition table (declare outside any function)
+inline TranspositionTable transpositionTable;
+
+// Buffers a search node needs, kept per ply so they are reused from node to node instead of
+// living on the stack (a MoveList is several kilobytes) or the heap.
+struct PlyScratch {
+    MoveList moves;
+    MoveList pushMoves;
+    // repetition detection: the node's hashBoard key, the plies since the last push-off or
+    // null move (along the path, into the game history at the root), and whether the move
+    // the node is searching now is one of those
+    uint64_t key = 0;
+    int reversiblePlies = 0;
+    bool irreversibleMove = false;
+    // the lowest ply whose position a repetition below this node went back to (negative: a
+    // position of the game history), NO_REPETITION if none; a result that depends on a position
+    // above the node depends on the path to it and isn't stored in the transposition table
+    int repetitionPly = 0;
+};
+
+constexpr int NO_REPETITION = INT_MAX;
+
+// scratch space of the current thread for a ply; a node may only use its own ply
+inline PlyScratch& plyScratch(int ply) {
+    thread_local std::deque<PlyScratch> plies;  // a deque keeps references valid as it grows
+    while (static_cast<int>(plies.size()) <= ply) {
+        plies.emplace_back();
+    }
+    return plies[ply];
+}
+
+// Has the position at ply (its key in plyScratch) been reached before, since the last push-off,
+// on the search path or in the game before the root? Only positions with the same side to move,
+// an even number of plies back, can match, and a position can't repeat within 2 plies.
+// Returns the ply of the earlier position (negative in the game history), or NO_REPETITION.
+inline int findRepetition(int ply, const SearchParams& params) {
+    const PlyScratch& scratch = plyScratch(ply);
+    const size_t gamePlies = params.history ? params.history->size() : 0;  // ends with the root
+    for (int back = 4; back <= scratch.reversiblePlies; back += 2) {
+        const uint64_t earlier = (back <= ply) ? plyScratch(ply - back).key
+                                               : (*params.history)[gamePlies - 1 - (back - ply)];
+        if (earlier == scratch.key) {
+            return ply - back;
+        }
+    }
+    return NO_REPETITION;
+}
+
+// Score of a repetition draw, from Black's point of view. The evaluation isn't centred on 0
+// (a side's centre proximity and cohesion count for it alone), so an even position is where
+// both sides' evaluations meet: their mean. Contempt moves it against params.rootSide.
+inline int drawScore(const AbaloneBoard& board, const SearchParams& params) {
+    const int even = (evaluatePosition<CellState::BLACK>(board) + evaluatePosition<CellState::WHITE>(board)) / 2;
+    return (params.rootSide == CellState::BLACK) ? even - params.contempt : even + params.contempt;
+}
+
+// after a child node (at ply + 1) returns: its repetitions are also repetitions below the node at ply
+inline void inheritRepetitions(PlyScratch& scratch, int ply) {
+    scratch.repetitionPly = std::min(scratch.repetitionPly, plyScratch(ply + 1).repetitionPly);
+}
+
+// board after playing a move
+inline AbaloneBoard boardAfterMove(const AbaloneBoard& board, const std::string& move) {
+    AbaloneBoard newBoard = board;
+    newBoard.makeMove(Move(move));
+    return newBoard;
+}
+
+// Principal variation: the best moves stored in the transposition table from a position on, up
+// to maxMoves of them, stopping at a missing or illegal entry or a repeated position
+inline std::vector<std::string> principalVariation(const AbaloneBoard& board, CellState toMove, int maxMoves) {
+    std::vector<std::string> moves;
+    AbaloneBoard position = board;
+    CellState side = toMove;
+    std::vector<uint64_t> seen = {hashBoard(position, side)};
+    MoveList legalMoves;
+    TTEntry entry;
+    while (static_cast<int>(moves.size()) < maxMoves &&
+           transpositionTable.probe(hashBoard(position, side), entry)) {
+        position.generateLegalMoves(side, legalMoves);
+        if (entry.move.empty() || !legalMoves.contains(entry.move)) {
+            break;
+        }
+        moves.push_back(entry.move.str());
+        position.makeMove(entry.move);
+        side = opponentOf(side);
+        const uint64_t key = hashBoard(position, side);
+        if (std::find(seen.begin(), seen.end(), key) != seen.end()) {
+            break;
+        }
+        seen.push_back(key);
+    }
+    return moves;
+}
+
+// Quiescence search: past the nominal depth keep searching pushes only, so a position is
+// never scored in the middle of an exchange where a marble is about to go off the board.
+// Scores are from Black's point of view like the rest of minimax. Us is the side to move;
+// the board is played on in place and is unchanged on return.
+// ply is the distance from the root, which selects the node's scratch space (see plyScratch).
+template <CellState Us>
+int quiescenceFor(AbaloneBoard& board, int alpha, int beta, int depth, const SearchParams& params, int ply) {
+    constexpr bool maximizing = Us == CellState::BLACK;
+    constexpr CellState Them = opponentOf(Us);
+    countNode(params);
+    countStat(params, &SearchStats::quiescenceNodes);
+    countStat(params, &SearchStats::evaluations);
+    // stand pat: the side to move can always decline to push
+    const int standPat = evaluatePosition<CellState::BLACK>(board);
+    if (depth == 0) {
+        return standPat;
+    }
+
+    if constexpr (maximizing) {
+        if (standPat >= beta) return standPat;
+        alpha = std::max(alpha, standPat);
+    } else {
+        if (standPat <= alpha) return standPat;
+        beta = std::min(beta, standPat);
+    }
+
+    MoveList& pushMoves = plyScratch(ply).pushMoves;
+    pushMoves.clear();
+    board.generatePushMoves<Us>(pushMoves);
+
+    int bestEval = standPat;
+    for (const Move& move : pushMoves) {
+        const MoveUndo undo = board.makeMove(move);
+        const int eval = quiescenceFor<Them>(board, alpha, beta, depth - 1, params, ply + 1);
+        board.unmakeMove(undo);
+        if constexpr (maximizing) {
+            bestEval = std::max(bestEval, eval);
+            alpha = std::max(alpha, bestEval);
+        } else {
+            bestEval = std::min(bestEval, eval);
+            beta = std::min(beta, bestEval);
+        }
+        if (beta <= alpha) break; // Alpha-beta pruning
+    }
+    return bestEval;
+}
+
+inline int quiescence(AbaloneBoard& board, int alpha, int beta, CellState currentPlayer, int depth,
+                      const SearchParams& params, int ply = 0) {
+    return (currentPlayer == CellState::BLACK)
+               ? quiescenceFor<CellState::BLACK>(board, alpha, beta, depth, params, ply)
+               : quiescenceFor<CellState::WHITE>(board, alpha, beta, depth, params, ply);
+}
+
+// score moves for alpha-beta: transposition table move first, then pushes (push-offs first),
+// then quiet moves. Returns the number of non-quiet moves; minimax picks them in score order
+// with MoveList::selectBest and searches the quiet moves in generation order.
+inline size_t orderMoves(MoveList& moves, const Move& ttMove, const MoveList& pushMoves) {
+    const int TT_MOVE_SCORE = 2 * static_cast<int>(MAX_LEGAL_MOVES);
+    size_t tacticalCount = 0;
+    for (size_t i = 0; i < moves.size(); i++) {
+        int score = 0;
+        if (!ttMove.empty() && moves[i] == ttMove) {
+            score = TT_MOVE_SCORE;
+        } else {
+            for (size_t push = 0; push < pushMoves.size(); push++) {
+                if (moves[i] == pushMoves[push]) {
+                    score = static_cast<int>(MAX_LEGAL_MOVES - push);
+                    break;
+                }
+            }
+        }
+        moves.score(i) = score;
+        if (score > 0) {
+            tacticalCount++;
+        }
+    }
+    return tacticalCount;
+}
+
+// Black maximises, White minimises; Us is the side to move. The board is played on in place
+// with makeMove/unmakeMove and is unchanged on return, also when the search is stopped.
+// allowNullMove is false at the root and directly below a null move.
+// ply is the distance from the root, which selects the node's scratch space (see plyScratch).
+template <CellState Us>
+std::pair<int, std::string> minimaxFor(AbaloneBoard& board, int depth, int alpha, int beta,
+                                       const SearchParams& params, bool allowNullMove, int ply) {
+    constexpr bool maximizing = Us == CellState::BLACK;
+    constexpr CellState Them = opponentOf(Us);
+
+    // Results of an abandoned search are never used or stored
+    if (searchStopped(params)) {
+        return {0, ""};
+    }
+
+    // A repeated position is a draw, and the loop isn't searched again
+    PlyScratch& scratch = plyScratch(ply);
+    scratch.key = hashBoard(board, Us);
+    scratch.repetitionPly = NO_REPETITION;
+    if (ply == 0) {
+        scratch.reversiblePlies = params.history ? static_cast<int>(params.history->size()) - 1 : 0;
+    } else {
+        const PlyScratch& parent = plyScratch(ply - 1);
+        scratch.reversiblePlies = parent.irreversibleMove ? 0 : parent.reversiblePlies + 1;
+        scratch.repetitionPly = findRepetition(ply, params);
+        if (scratch.repetitionPly != NO_REPETITION) {
+            countStat(params, &SearchStats::repetitions);
+            countStat(params, &SearchStats::evaluations);
+            return {drawScore(board, params), ""};
+        }
+    }
+
+    // Base case: depth 0 or terminal state (quiescence counts its own nodes)
+    if (depth <= 0) {
+        return {quiescenceFor<Us>(board, alpha, beta, params.quiescenceDepth, params, ply), ""};
+    }
+
+    countNode(params);
+    MoveList& legalMoves = scratch.moves;
+    board.generateLegalMoves<Us>(legalMoves);
+    if (legalMoves.empty()) {
+        countStat(params, &SearchStats::evaluations);
+        return {evaluatePosition<CellState::BLACK>(board), ""};
+    }
+
+    // Check transposition table (the key includes the side to move, null moves reach the same board
+    // with either). An entry whose move isn't legal here belongs to another position with the same key.
+    Move ttMove;
+    TTEntry entry;
+    countStat(params, &SearchStats::ttProbes);
+    if (transpositionTable.probe(scratch.key, entry) && legalMoves.contains(entry.move)) {
+        countStat(params, &SearchStats::ttHits);
+        if (entry.depth >= depth && (entry.bound == TTBound::EXACT ||
+                                     (entry.bound == TTBound::LOWER && entry.score >= beta) ||
+                                     (entry.bound == TTBound::UPPER && entry.score <= alpha))) {
+            countStat(params, &SearchStats::ttCutoffs);
+            return {entry.score, entry.move.str()}; // Reuse cached result if depth is sufficient
+        }
+        ttMove = entry.move;
+    }
+
+    // Null-move pruning, skipped when the opponent could push one of our marbles off
+    if (params.nullMove && allowNullMove && depth >= params.nullMoveMinDepth && !board.canPushOff<Them>()) {
+        const int nullDepth = depth - 1 - params.nullMoveReduction;
+        const int verifyDepth = depth - params.nullMoveReduction;
+        scratch.irreversibleMove = true;  // no repetitions through a null move
+        if constexpr (maximizing) {
+            const int nullEval = minimaxFor<Them>(board, nullDepth, beta - 1, beta, params, false, ply + 1).first;
+            if (searchStopped(params)) {
+                return {0, ""};
+            }
+            inheritRepetitions(scratch, ply);
+            const bool cutoff = nullEval >= beta && (!params.nullMoveVerification ||
+                                                     minimaxFor<Us>(board, verifyDepth, beta - 1, beta, params, false, ply + 1).first >= beta);
+            inheritRepetitions(scratch, ply);
+            if (cutoff) {
+                countStat(params, &SearchStats::nullMoveCutoffs);
+                return {nullEval, ""};
+            }
+        } else {
+            const int nullEval = minimaxFor<Them>(board, nullDepth, alpha, alpha + 1, params, false, ply + 1).first;
+            if (searchStopped(params)) {
+                return {0, ""};
+            }
+            inheritRepetitions(scratch, ply);
+            const bool cutoff = nullEval <= alpha && (!params.nullMoveVerification ||
+                                                      minimaxFor<Us>(board, verifyDepth, alpha, alpha + 1, params, false, ply + 1).first <= alpha);
+            inheritRepetitions(scratch, ply);
+            if (cutoff) {
+                countStat(params, &SearchStats::nullMoveCutoffs);
+                return {nullEval, ""};
+            }
+        }
+    }
+
+    MoveList& pushMoves = scratch.pushMoves;
+    pushMoves.clear();
+    board.generatePushMoves<Us>(pushMoves);
+    const size_t tacticalCount = orderMoves(legalMoves, ttMove, pushMoves);
+    countPlyStat(params, &SearchStats::plyNodes, ply);
+    countPlyStat(params, &SearchStats::plyLegalMoves, ply, legalMoves.size());
+
+    const int alphaOrig = alpha;
+    const int betaOrig = beta;
+    Move bestMove;
+    int bestEval = maximizing ? INT_MIN : INT_MAX;
+    size_t movesSearched = legalMoves.size();  // fewer after a cutoff
+
+    for (size_t moveNumber = 0; moveNumber < legalMoves.size(); moveNumber++) {
+        if (moveNumber < tacticalCount) {
+            legalMoves.selectBest(moveNumber);
+        }
+        const Move move = legalMoves[moveNumber];
+        const MoveUndo undo = board.makeMove(move);
+        scratch.irreversibleMove = undo.pushOff;
+
+        // Late move reduction: search quiet late moves shallower with a null window,
+        // and re-search at full depth only if they look better than what we have
+        int eval = 0;
+        bool fullSearch = true;
+        if (params.lateMoveReductions && depth >= params.lmrMinDepth &&
+            moveNumber >= static_cast<size_t>(params.lmrFullDepthMoves) && moveNumber >= tacticalCount) {
+            const int reducedDepth = depth - 1 - params.lmrReduction;
+            if constexpr (maximizing) {
+                eval = minimaxFor<Them>(board, reducedDepth, alpha, alpha + 1, params, true, ply + 1).first;
+                fullSearch = eval > alpha;
+            } else {
+                eval = minimaxFor<Them>(board, reducedDepth, beta - 1, beta, params, true, ply + 1).first;
+                fullSearch = eval < beta;
+            }
+            inheritRepetitions(scratch, ply);
+            if (fullSearch) {
+                countStat(params, &SearchStats::lmrResearches);
+            }
+        }
+        if (fullSearch) {
+            eval = minimaxFor<Them>(board, depth - 1, alpha, beta, params, true, ply + 1).first;
+            inheritRepetitions(scratch, ply);
+        }
+        board.unmakeMove(undo);
+        if (searchStopped(params)) {
+            return {0, ""};
+        }
+
+        if (maximizing ? eval > bestEval : eval < bestEval) {
+            bestEval = eval;
+            bestMove = move;
+        }
+        if constexpr (maximizing) {
+            alpha = std::max(alpha, bestEval);
+        } else {
+            beta = std::min(beta, bestEval);
+        }
+        if (beta <= alpha) { // Alpha-beta pruning
+            countStat(params, &SearchStats::betaCutoffs);
+            if (moveNumber == 0) {
+                countStat(params, &SearchStats::firstMoveCutoffs);
+            }
+            movesSearched = moveNumber + 1;
+            break;
+        }
+    }
+    countPlyStat(params, &SearchStats::plySearchedMoves, ply, movesSearched);
+
+    // Store result in transposition table. A score that counts a repetition of a position above
+    // this node is only right on this path, so it is stored at depth 0: it keeps the move for
+    // move ordering and the principal variation, but is never used as a score
+    const TTBound bound = (bestEval <= alphaOrig) ? TTBound::UPPER
+                        : (bestEval >= betaOrig) ? TTBound::LOWER : TTBound::EXACT;
+    const bool pathDependent = scratch.repetitionPly < ply;
+    countStat(params, &SearchStats::ttStores);
+    if (transpositionTable.store(scratch.key, bestEval, pathDependent ? 0 : depth, bestMove, bound)) {
+        countStat(params, &SearchStats::ttCollisions);
+    }
+    return {bestEval, bestMove.str()};
+}
+
+// picks the specialised search for the side to move once; the recursion stays in minimaxFor
+inline std::pair<int, std::string> minimax(AbaloneBoard& board, int depth, int alpha, int beta, CellState currentPlayer,
+                                           const SearchParams& params = SearchParams(), bool allowNullMove = true,
+                                           int ply = 0) {
+    if (params.rootSide == CellState::EMPTY) {
+        SearchParams rootParams = params;
+        rootParams.rootSide = currentPlayer;
+        return minimax(board, depth, alpha, beta, currentPlayer, rootParams, allowNullMove, ply);
+    }
+    return (currentPlayer == CellState::BLACK)
+               ? minimaxFor<CellState::BLACK>(board, depth, alpha, beta, params, allowNullMove, ply)
+               : minimaxFor<CellState::WHITE>(board, depth, alpha, beta, params, allowNullMove, ply);
+}
+
+// Search a root position to a fixed depth. With params.threads > 1, helper threads search the
+// same position at the same time (lazy SMP), half of them one ply deeper, and share what they
+// find through the transposition table. Only the main thread's result is used.
+inline std::pair<int, std::string> searchRoot(AbaloneBoard& board, CellState player, int depth,
+                                              const SearchParams& params) {
+    if (params.threads <= 1) {
+        return minimax(board, depth, INT_MIN, INT_MAX, player, params, false);
+    }
+    std::atomic<bool> helpersStop{false};
+    SearchParams helperParams = params;
+    helperParams.stop = &helpersStop;
+    helperParams.onIteration = nullptr;
+    std::vector<std::thread> helpers;
+    for (int helper = 1; helper < params.threads; helper++) {
+        // each helper gets its own copy, made before the main search starts playing on board
+        helpers.emplace_back([helperBoard = board, player, depth, helper, &helperParams]() mutable {
+            minimax(helperBoard, depth + helper % 2, INT_MIN, INT_MAX, player, helperParams, false);
+        });
+    }
+    auto result = minimax(board, depth, INT_MIN, INT_MAX, player, params, false);
+    helpersStop = true;
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+    return result;
+}
+
+// search a root position by iterative deepening up to params.depth. If the search is stopped,
+// the result of the last completed iteration is returned.
+inline SearchResult searchBestMove(AbaloneBoard& board, CellState player, const SearchParams& params) {
+    transpositionTable.newSearch();
+    SearchResult result;
+    for (int depth = 1; depth <= params.depth; depth++) {
+        TRACE_SCOPE("iteration");
+        const auto iterationStart = std::chrono::steady_clock::now();
+        const uint64_t nodesBefore = params.stats ? params.stats->nodes.load() : 0;
+        auto [score, move] = searchRoot(board, player, depth, params);
+        if (searchStopped(params) || move.empty()) {
+            break;
+        }
+        result = {score, move, depth};
+        if (params.stats) {
+            const auto elapsed = std::chrono::steady_clock::now() - iterationStart;
+            params.stats->iterations.push_back(
+                {depth, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(),
+                 params.stats->nodes.load() - nodesBefore, score, move});
+        }
+        if (params.onIteration) {
+            params.onIteration(result);
+        }
+    }
+    return result;
+}
+
+
+#endif // ABALONE_ENGINE_H
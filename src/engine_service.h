@@ -0,0 +1,99 @@
+#ifndef ABALONE_ENGINE_SERVICE_H
+#define ABALONE_ENGINE_SERVICE_H
+
+#include "engine.h"
+
+#include <mutex>
+#include <thread>
+
+// snapshot of a running search
+struct SearchProgress {
+    int depth = 0;          // deepest completed iteration
+    std::string bestMove;   // best move of that iteration
+    int score = 0;
+    uint64_t nodes = 0;     // nodes searched so far
+    bool done = false;      // the search has finished (or was stopped)
+};
+
+// Runs searchBestMove on a background thread so the caller stays responsive. The caller can poll
+// progress and stop the search early, keeping the best move found so far.
+// Only one search may run at a time because all searches share the transposition table.
+class EngineService {
+    std::thread thread;
+    std::atomic<bool> stopFlag{false};
+    std::atomic<bool> finished{false};
+    std::atomic<uint64_t> nodes{0};
+    mutable std::mutex mutex;
+    SearchResult best;  // last completed iteration, guarded by mutex
+
+public:
+    EngineService() = default;
+    EngineService(const EngineService&) = delete;
+    EngineService& operator=(const EngineService&) = delete;
+
+    ~EngineService() {
+        stop();
+    }
+
+    // start searching a position; a search that is still running is stopped first. The
+    // params.onIteration of the caller is still called, on the search thread, after each iteration.
+    void start(const AbaloneBoard& board, CellState player, SearchParams params) {
+        stop();
+        stopFlag = false;
+        finished = false;
+        nodes = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            best = SearchResult();
+        }
+        params.stop = &stopFlag;
+        params.nodes = &nodes;
+        params.onIteration = [this, onIteration = std::move(params.onIteration)](const SearchResult& result) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                best = result;
+            }
+            if (onIteration) {
+                onIteration(result);
+            }
+        };
+        thread = std::thread([this, searchBoard = board, player, params]() mutable {
+            searchBestMove(searchBoard, player, params);
+            finished = true;
+        });
+    }
+
+    [[nodiscard]] bool isRunning() const {
+        return thread.joinable();
+    }
+
+    [[nodiscard]] SearchProgress poll() const {
+        SearchProgress progress;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            progress.depth = best.depth;
+            progress.bestMove = best.move;
+            progress.score = best.score;
+        }
+        progress.nodes = nodes.load(std::memory_order_relaxed);
+        progress.done = finished.load();
+        return progress;
+    }
+
+    // wait for the search to finish on its own and return its result
+    SearchResult wait() {
+        if (thread.joinable()) {
+            thread.join();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        return best;
+    }
+
+    // stop the search now and return the best move found so far
+    SearchResult stop() {
+        stopFlag = true;
+        return wait();
+    }
+};
+
+#endif // ABALONE_ENGINE_SERVICE_H
@@ -0,0 +1,89 @@
+#ifndef ABALONE_EVAL_WEIGHTS_H
+#define ABALONE_EVAL_WEIGHTS_H
+
+#include "engine.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+/*
+ * Evaluation weights files: one "name weight" pair per line, with the names of
+ * EVAL_FEATURE_NAMES, e.g.
+ *     cohesion 65
+ * '#' starts a comment. Features the file doesn't mention keep the weight they had, and a
+ * weight of 0 switches the feature off. tune writes these files; trial --weights <file> plays
+ * with them. The same settings can be given on the command line as "name=weight,name=weight"
+ * (trial --eval), which is handy for A/B matches between weight sets without writing files.
+ */
+
+// the EvalFeature with that name, or EVAL_FEATURE_COUNT if there is none
+inline int evalFeatureIndex(const std::string& name) {
+    const auto feature = std::find_if(EVAL_FEATURE_NAMES.begin(), EVAL_FEATURE_NAMES.end(),
+                                      [&name](const char* featureName) { return name == featureName; });
+    return static_cast<int>(feature - EVAL_FEATURE_NAMES.begin());
+}
+
+// returns false, and leaves weights as they were, if the file is missing or malformed
+inline bool readEvalWeights(const std::string& filename, EvalWeights& weights) {
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return false;
+    }
+    EvalWeights result = weights;
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+        std::istringstream fields(line.substr(0, line.find('#')));
+        std::string name;
+        if (!(fields >> name)) {
+            continue;  // blank or comment line
+        }
+        int weight = 0;
+        const int feature = evalFeatureIndex(name);
+        std::string rest;
+        if (feature == EVAL_FEATURE_COUNT || !(fields >> weight) || (fields >> rest)) {
+            std::cerr << "Error: " << filename << ":" << lineNumber << ": expected <feature> <weight>, got \""
+                      << line << "\"" << std::endl;
+            return false;
+        }
+        result[feature] = weight;
+    }
+    weights = result;
+    return true;
+}
+
+// "name=weight,name=weight..."; returns false, and leaves weights as they were, if it's malformed
+inline bool parseEvalWeights(const std::string& spec, EvalWeights& weights) {
+    EvalWeights result = weights;
+    std::istringstream settings(spec);
+    for (std::string setting; std::getline(settings, setting, ',');) {
+        const size_t equals = setting.find('=');
+        const int feature = (equals == std::string::npos) ? EVAL_FEATURE_COUNT : evalFeatureIndex(setting.substr(0, equals));
+        std::istringstream value(equals == std::string::npos ? "" : setting.substr(equals + 1));
+        int weight = 0;
+        std::string rest;
+        if (feature == EVAL_FEATURE_COUNT || !(value >> weight) || (value >> rest)) {
+            std::cerr << "Error: expected <feature>=<weight>, got \"" << setting << "\"" << std::endl;
+            return false;
+        }
+        result[feature] = weight;
+    }
+    weights = result;
+    return true;
+}
+
+// comment goes at the top of the file, one "# " line per line of comment
+inline bool writeEvalWeights(const std::string& filename, const EvalWeights& weights, const std::string& comment) {
+    std::ofstream file(filename);
+    std::istringstream commentLines(comment);
+    for (std::string line; std::getline(commentLines, line);) {
+        file << "# " << line << "\n";
+    }
+    for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+        file << EVAL_FEATURE_NAMES[feature] << " " << weights[feature] << "\n";
+    }
+    return static_cast<bool>(file.flush());
+}
+
+#endif // ABALONE_EVAL_WEIGHTS_H
@@ -0,0 +1,476 @@
+#ifndef ABALONE_GAMERECORD_H
+#define ABALONE_GAMERECORD_H
+
+#include "engine.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * Game record file layout (all fields little-endian, as written by the writer). A file holds
+ * any number of games back to back, each one
+ *   GameHeader
+ *   plyCount records of
+ *     uint16_t move                 encoded with encodeMove, or, with GAME_HAS_STATS,
+ *     PlyRecord                     the move followed by the search that chose it
+ * Records have a fixed size, so any ply of a game is one multiplication away. Positions are
+ * not stored: they are replayed from the layout with makeMove (see GameReplay).
+ */
+
+const char GAME_MAGIC[8] = {'A', 'B', 'A', 'G', 'A', 'M', 'E', '\0'};
+const uint32_t GAME_VERSION = 1;
+const uint32_t GAME_UNFINISHED = 0xFFFFFFFF;  // plyCount of a game whose writer never finished it
+const uint8_t GAME_HAS_STATS = 1;             // GameHeader::flags
+
+enum class GameResult : uint8_t { NONE, BLACK_WINS, WHITE_WINS, DRAW };  // DRAW: by repetition
+
+// who chose a move
+enum class MoveSource : uint8_t { PLAYER, SEARCH, BOOK, PONDER, MCTS };
+
+struct GameHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t plyCount;
+    uint8_t layout;        // 1 = Default, 2 = German, 3 = Belgian
+    uint8_t firstToMove;   // 0 = black, 1 = white
+    uint8_t flags;
+    uint8_t result;        // GameResult
+    // engine settings
+    uint8_t engineSide;    // 0 = black, 1 = white, 2 = both (self-play)
+    uint8_t depth;
+    uint8_t quiescenceDepth;
+    uint8_t threads;
+    uint8_t nullMove;
+    uint8_t lateMoveReductions;
+    uint8_t reserved[6];
+};
+
+struct PlyRecord {
+    uint16_t move;
+    uint8_t source;        // MoveSource
+    uint8_t depth;         // completed search depth, 0 if there was no search
+    int32_t score;         // from Black's point of view (MCTS: Black's expected result in per mille)
+    uint32_t nodes;        // MCTS: playouts
+    uint32_t timeMs;
+};
+
+/*
+ * Moves are encoded in 16 bits:
+ *   inline:   cell * 6 + dir                                   cell of the rear marble
+ *   sidestep: 0x8000 | ((cell * 3 + axis) * 2 + size - 2) * 6 + dir
+ * where a sidestep group starts at cell and runs along axis (NE, NW or E) for size marbles.
+ */
+const uint16_t MOVE_SIDESTEP = 0x8000;
+const uint16_t NO_MOVE = 0xFFFF;
+
+inline uint16_t encodeMove(const Move& move) {
+    const std::string_view text = move.view();
+    if (text.size() >= 4 && text[0] == 'i' && AbaloneBoard::isValidPosition(std::string(text.substr(1, 2)))) {
+        const int dir = directionIndex(text.substr(3));
+        if (dir >= 0) {
+            return static_cast<uint16_t>(cellIndex(text.substr(1, 2)) * DIRECTION_COUNT + dir);
+        }
+    } else if (text.size() >= 6 && text[0] == 's' && AbaloneBoard::isValidPosition(std::string(text.substr(1, 2))) &&
+               AbaloneBoard::isValidPosition(std::string(text.substr(3, 2)))) {
+        const int first = cellIndex(text.substr(1, 2));
+        const int last = cellIndex(text.substr(3, 2));
+        const int dir = directionIndex(text.substr(5));
+        for (int axis = 0; axis < 3 && dir >= 0; axis++) {
+            const int second = boardGeometry.neighbour[first][axis];
+            const int third = (second < 0) ? -1 : boardGeometry.neighbour[second][axis];
+            const int size = (second == last) ? 2 : (third >= 0 && third == last) ? 3 : 0;
+            if (size > 0) {
+                return static_cast<uint16_t>(MOVE_SIDESTEP |
+                                             (((first * 3 + axis) * 2 + size - 2) * DIRECTION_COUNT + dir));
+            }
+        }
+    }
+    return NO_MOVE;
+}
+
+// the move for a code from encodeMove; an empty move for a code that is not one
+inline Move decodeMove(uint16_t code) {
+    if (code & MOVE_SIDESTEP) {
+        int value = code & ~MOVE_SIDESTEP;
+        const int dir = value % DIRECTION_COUNT;
+        value /= DIRECTION_COUNT;
+        const int size = value % 2 + 2;
+        value /= 2;
+        const int axis = value % 3;
+        const int first = value / 3;
+        if (first >= NUM_CELLS) {
+            return Move();
+        }
+        int last = first;
+        for (int i = 1; i < size && last >= 0; i++) {
+            last = boardGeometry.neighbour[last][axis];
+        }
+        return (last < 0) ? Move() : Move('s', cellNames[first], cellNames[last], directions[dir]);
+    }
+    const int cell = code / DIRECTION_COUNT;
+    return (cell < NUM_CELLS) ? Move('i', cellNames[cell], directions[code % DIRECTION_COUNT]) : Move();
+}
+
+// bytes per ply of a game
+inline size_t gameRecordSize(const GameHeader& header) {
+    return (header.flags & GAME_HAS_STATS) ? sizeof(PlyRecord) : sizeof(uint16_t);
+}
+
+// Appends games to a record file as they are played. The moves of a game go to the file as
+// they come (through stdio's buffer); finishGame fills in the header's ply count and result.
+// A write that fails ends the recording: the calls return false from then on.
+class GameRecordWriter {
+    FILE* file = nullptr;
+    long headerOffset = -1;  // of the game in progress, -1 if there is none
+    GameHeader header{};
+
+public:
+    GameRecordWriter() = default;
+    GameRecordWriter(const GameRecordWriter&) = delete;
+    GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+    ~GameRecordWriter() {
+        close();
+    }
+
+    // Open a record file for appending games, creating it if needed. A game a killed writer
+    // left unfinished gets the ply count of the records it has, and whatever follows the last
+    // intact game (a partly written record, or bytes that aren't a game) is cut off, so the
+    // games appended next can be read back.
+    bool open(const std::string& filename) {
+        close();
+        file = std::fopen(filename.c_str(), "r+b");
+        if (!file) {
+            file = std::fopen(filename.c_str(), "w+b");
+        }
+        if (file && !repair()) {
+            std::fclose(file);
+            file = nullptr;
+        }
+        return file != nullptr;
+    }
+
+    [[nodiscard]] bool isOpen() const {
+        return file != nullptr;
+    }
+
+    // start a game; engineSide: 0 = black, 1 = white, 2 = both
+    bool beginGame(int layout, CellState firstToMove, int engineSide, const SearchParams& params, bool withStats) {
+        if (!file || !finishGame(GameResult::NONE)) {
+            return false;
+        }
+        header = GameHeader{};
+        std::memcpy(header.magic, GAME_MAGIC, sizeof(GAME_MAGIC));
+        header.version = GAME_VERSION;
+        header.plyCount = GAME_UNFINISHED;
+        header.layout = static_cast<uint8_t>(layout);
+        header.firstToMove = (firstToMove == CellState::BLACK) ? 0 : 1;
+        header.flags = withStats ? GAME_HAS_STATS : 0;
+        header.engineSide = static_cast<uint8_t>(engineSide);
+        header.depth = static_cast<uint8_t>(params.depth);
+        header.quiescenceDepth = static_cast<uint8_t>(params.quiescenceDepth);
+        header.threads = static_cast<uint8_t>(std::min(params.threads, 255));
+        header.nullMove = params.nullMove ? 1 : 0;
+        header.lateMoveReductions = params.lateMoveReductions ? 1 : 0;
+        headerOffset = std::ftell(file);
+        if (!write(&header, sizeof(header))) {
+            return false;
+        }
+        header.plyCount = 0;
+        return true;
+    }
+
+    // record the next ply; the statistics are only written if the game was begun withStats
+    bool addMove(const std::string& move, const PlyRecord& stats = PlyRecord{}) {
+        if (!file || headerOffset < 0) {
+            return false;
+        }
+        PlyRecord record = stats;
+        record.move = encodeMove(Move(move));
+        if (!((header.flags & GAME_HAS_STATS) ? write(&record, sizeof(record)) : write(&record.move, sizeof(record.move)))) {
+            return false;
+        }
+        header.plyCount++;
+        return true;
+    }
+
+    // complete the game in progress, if any, and flush it to disk
+    bool finishGame(GameResult result) {
+        if (!file) {
+            return false;
+        }
+        if (headerOffset < 0) {
+            return true;
+        }
+        header.result = static_cast<uint8_t>(result);
+        const long end = std::ftell(file);
+        if (end < 0 || std::fseek(file, headerOffset, SEEK_SET) != 0 || !write(&header, sizeof(header)) ||
+            std::fseek(file, end, SEEK_SET) != 0 || std::fflush(file) != 0) {
+            if (file) {
+                fail();
+            }
+            return false;
+        }
+        headerOffset = -1;
+        return true;
+    }
+
+    // finishes the game in progress without a result
+    void close() {
+        if (file) {
+            finishGame(GameResult::NONE);
+        }
+        if (file) {
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+
+private:
+    bool write(const void* data, size_t size) {
+        if (std::fwrite(data, size, 1, file) != 1) {
+            fail();
+            return false;
+        }
+        return true;
+    }
+
+    void fail() {
+        std::fclose(file);
+        file = nullptr;
+        headerOffset = -1;
+    }
+
+    // walk the games of the file, fix up its last one and cut off what follows it (see open)
+    bool repair() {
+        if (std::fseek(file, 0, SEEK_END) != 0) {
+            return false;
+        }
+        const long length = std::ftell(file);
+        long offset = 0;
+        GameHeader existing{};
+        while (length - offset >= static_cast<long>(sizeof(GameHeader))) {
+            if (std::fseek(file, offset, SEEK_SET) != 0 || std::fread(&existing, sizeof(existing), 1, file) != 1) {
+                return false;
+            }
+            if (std::memcmp(existing.magic, GAME_MAGIC, sizeof(GAME_MAGIC)) != 0 || existing.version != GAME_VERSION ||
+                existing.layout < 1 || existing.layout > 3) {
+                break;
+            }
+            const long recordSize = static_cast<long>(gameRecordSize(existing));
+            const long available = (length - offset - static_cast<long>(sizeof(GameHeader))) / recordSize;
+            if (existing.plyCount == GAME_UNFINISHED || existing.plyCount > available) {
+                existing.plyCount = static_cast<uint32_t>(available);
+                if (std::fseek(file, offset, SEEK_SET) != 0 || std::fwrite(&existing, sizeof(existing), 1, file) != 1) {
+                    return false;
+                }
+                offset += static_cast<long>(sizeof(GameHeader)) + available * recordSize;
+                break;
+            }
+            offset += static_cast<long>(sizeof(GameHeader)) + static_cast<long>(existing.plyCount) * recordSize;
+        }
+        if (std::fflush(file) != 0 || (offset < length && ftruncate(fileno(file), offset) != 0)) {
+            return false;
+        }
+        return std::fseek(file, 0, SEEK_END) == 0;
+    }
+};
+
+// one game of a record file, pointing into the file's memory
+class GameRecord {
+    const GameHeader* header = nullptr;
+    const char* records = nullptr;
+    uint32_t plies = 0;
+
+public:
+    GameRecord() = default;
+    GameRecord(const GameHeader* gameHeader, const char* gameRecords, uint32_t plyCount)
+        : header(gameHeader), records(gameRecords), plies(plyCount) {}
+
+    [[nodiscard]] const GameHeader& info() const {
+        return *header;
+    }
+
+    [[nodiscard]] uint32_t plyCount() const {
+        return plies;
+    }
+
+    [[nodiscard]] bool hasStats() const {
+        return header->flags & GAME_HAS_STATS;
+    }
+
+    [[nodiscard]] static size_t recordSize(const GameHeader& gameHeader) {
+        return gameRecordSize(gameHeader);
+    }
+
+    // the move played at a ply (0 = the first move)
+    [[nodiscard]] Move move(uint32_t ply) const {
+        uint16_t code;
+        std::memcpy(&code, records + ply * recordSize(*header), sizeof(code));
+        return decodeMove(code);
+    }
+
+    // the move and its search at a ply; only the move is set if the game has no statistics
+    [[nodiscard]] PlyRecord stats(uint32_t ply) const {
+        PlyRecord record{};
+        std::memcpy(&record, records + ply * recordSize(*header), recordSize(*header));
+        return record;
+    }
+
+    [[nodiscard]] CellState firstToMove() const {
+        return header->firstToMove == 0 ? CellState::BLACK : CellState::WHITE;
+    }
+};
+
+// read-only, memory-mapped record file
+class GameRecordFile {
+    const char* data = nullptr;
+    size_t length = 0;
+    std::vector<GameRecord> games;
+
+public:
+    GameRecordFile() = default;
+    GameRecordFile(const GameRecordFile&) = delete;
+    GameRecordFile& operator=(const GameRecordFile&) = delete;
+
+    ~GameRecordFile() {
+        close();
+    }
+
+    // Map a record file and index its games. Returns false if it is missing or holds no
+    // complete header; a malformed tail (e.g. a game cut off by a crash, or a header with an
+    // unknown layout) is left out.
+    bool open(const std::string& filename) {
+        close();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1) {
+            return false;
+        }
+        struct stat sb{};
+        if (fstat(fd, &sb) == -1 || static_cast<size_t>(sb.st_size) < sizeof(GameHeader)) {
+            ::close(fd);
+            return false;
+        }
+        length = sb.st_size;
+        void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // the mapping stays valid after closing the descriptor
+        if (addr == MAP_FAILED) {
+            length = 0;
+            return false;
+        }
+        data = static_cast<const char*>(addr);
+
+        size_t offset = 0;
+        while (length - offset >= sizeof(GameHeader)) {
+            const auto* header = reinterpret_cast<const GameHeader*>(data + offset);
+            if (std::memcmp(header->magic, GAME_MAGIC, sizeof(GAME_MAGIC)) != 0 || header->version != GAME_VERSION ||
+                header->layout < 1 || header->layout > 3) {
+                break;
+            }
+            const size_t recordSize = GameRecord::recordSize(*header);
+            const size_t available = (length - offset - sizeof(GameHeader)) / recordSize;
+            // an unfinished game runs to the end of the file
+            const size_t plies = (header->plyCount == GAME_UNFINISHED) ? available
+                                                                         : std::min<size_t>(header->plyCount, available);
+            games.emplace_back(header, data + offset + sizeof(GameHeader), static_cast<uint32_t>(plies));
+            if (header->plyCount == GAME_UNFINISHED || plies < header->plyCount) {
+                break;
+            }
+            offset += sizeof(GameHeader) + plies * recordSize;
+        }
+        if (games.empty()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (data) {
+            munmap(const_cast<char*>(data), length);
+        }
+        data = nullptr;
+        length = 0;
+        games.clear();
+    }
+
+    [[nodiscard]] size_t gameCount() const {
+        return games.size();
+    }
+
+    [[nodiscard]] const GameRecord& game(size_t index) const {
+        return games[index];
+    }
+};
+
+// Replays a recorded game: the position before any ply, reached with makeMove from the layout.
+// Seeking forward plays the moves in between; seeking back takes them back with unmakeMove.
+// The game ends at the first recorded move that isn't legal (a corrupt record or NO_MOVE), so
+// only legal moves ever reach makeMove.
+class GameReplay {
+    GameRecord record;
+    AbaloneBoard board;
+    CellState toMove = CellState::BLACK;
+    std::vector<MoveUndo> undos;  // one per ply played
+    uint32_t plies = 0;           // plies that can be replayed
+
+public:
+    explicit GameReplay(const GameRecord& game) : record(game), toMove(game.firstToMove()) {
+        for (const auto& [pos, color] : parseBoardFromString(layoutString(game.info().layout))) {
+            board.setCellState(pos, color == 'b' ? CellState::BLACK : CellState::WHITE);
+        }
+        undos.reserve(game.plyCount());
+
+        // play the game through once to find its first illegal move
+        MoveList legalMoves;
+        while (plies < game.plyCount()) {
+            board.generateLegalMoves(toMove, legalMoves);
+            if (!legalMoves.contains(game.move(plies))) {
+                break;
+            }
+            plies++;
+            seek(plies);
+        }
+        seek(0);
+    }
+
+    [[nodiscard]] uint32_t ply() const {
+        return static_cast<uint32_t>(undos.size());
+    }
+
+    // the plies of the game up to its first illegal move; at most the record's plyCount()
+    [[nodiscard]] uint32_t plyCount() const {
+        return plies;
+    }
+
+    [[nodiscard]] const AbaloneBoard& position() const {
+        return board;
+    }
+
+    [[nodiscard]] CellState sideToMove() const {
+        return toMove;
+    }
+
+    // move to the position before ply (plyCount() for the final position)
+    void seek(uint32_t target) {
+        target = std::min(target, plies);
+        while (ply() < target) {
+            undos.push_back(board.makeMove(record.move(ply())));
+            toMove = opponentOf(toMove);
+        }
+        while (ply() > target) {
+            board.unmakeMove(undos.back());
+            undos.pop_back();
+            toMove = opponentOf(toMove);
+        }
+    }
+};
+
+#endif // ABALONE_GAMERECORD_H
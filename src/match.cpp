@@ -0,0 +1,252 @@
+#include "engine.h"
+#include "engine_service.h"
+#include "eval_weights.h"
+#include "gamerecord.h"
+#include "mcts.h"
+
+#include <iostream>
+#include <memory>
+#include <random>
+
+/*
+ * Tournament runner: play two engines against each other with the same think time per move,
+ * e.g. alpha-beta against MCTS, or one set of evaluation weights against another.
+ *
+ * Every opening (a standard layout and a few random moves, so games differ) is played twice
+ * with the colours swapped. Games end when a side is down to 8 marbles, in a draw when a
+ * position is on the board for the third time, or after --max-plies; unfinished games are
+ * scored by the marbles left.
+ *
+ * usage: match [options] <engine A> <engine B>
+ *   engine: ab | mcts | mcts-root, optionally with evaluation weights as for trial --eval,
+ *           e.g. ab:exposed=-80,edge=-30
+ *   --games n         openings to play, each twice (default 10)
+ *   --time ms         think time per move (default 1000)
+ *   --depth n         alpha-beta depth limit (default: none within the time)
+ *   --threads n       search threads of both engines (default 1)
+ *   --random-plies n  random opening moves (default 2)
+ *   --max-plies n     (default 300)
+ *   --seed n          (default 1)
+ *   --record <file>   append the games to a game record file (see gamerecord.h)
+ */
+
+struct MatchOptions {
+    int games = 10;
+    int timeMs = 1000;
+    int depth = 64;
+    int threads = 1;
+    int randomPlies = 2;
+    int maxPlies = 300;
+    uint64_t seed = 1;
+};
+
+// one side of the match
+struct Player {
+    std::string name;
+    bool mcts = false;
+    EvalWeights weights = evalWeights();
+    std::unique_ptr<MctsEngine> mctsEngine;
+    EngineService alphaBeta;
+
+    // parse "ab", "mcts" or "mcts-root", with ":<feature>=<weight>,..." after it
+    bool parse(const std::string& spec, const MatchOptions& options) {
+        name = spec;
+        const size_t colon = spec.find(':');
+        const std::string engine = spec.substr(0, colon);
+        if (colon != std::string::npos && !parseEvalWeights(spec.substr(colon + 1), weights)) {
+            return false;
+        }
+        if (engine == "mcts" || engine == "mcts-root") {
+            mcts = true;
+            MctsParams params;
+            params.timeMs = options.timeMs;
+            params.threads = options.threads;
+            params.parallelism = (engine == "mcts-root") ? MctsParallelism::ROOT : MctsParallelism::TREE;
+            params.seed = options.seed;
+            mctsEngine = std::make_unique<MctsEngine>(params);
+        } else if (engine != "ab") {
+            std::cerr << "Error: unknown engine \"" << engine << "\" (ab, mcts or mcts-root)" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // choose a move; fills in the statistics for the game record
+    std::string play(const AbaloneBoard& board, CellState toMove, const GameHistory& history,
+                     const MatchOptions& options, PlyRecord& stats) {
+        setEvalWeights(weights);
+        if (mcts) {
+            const MctsResult result = mctsEngine->search(board, toMove);
+            stats.source = static_cast<uint8_t>(MoveSource::MCTS);
+            stats.score = static_cast<int32_t>(
+                std::lround(1000 * (toMove == CellState::BLACK ? result.value : 1 - result.value)));
+            stats.nodes = static_cast<uint32_t>(result.playouts);
+            return result.move;
+        }
+        // alpha-beta by iterative deepening until the time is up; the table is cleared so the
+        // two sides never read each other's scores
+        transpositionTable.clear();
+        SearchParams params;
+        params.depth = options.depth;
+        params.threads = options.threads;
+        params.history = &history.positions();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeMs);
+        alphaBeta.start(board, toMove, params);
+        while (!alphaBeta.poll().done && (options.timeMs == 0 || std::chrono::steady_clock::now() < deadline)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const uint64_t nodes = alphaBeta.poll().nodes;
+        const SearchResult result = alphaBeta.stop();
+        stats.source = static_cast<uint8_t>(MoveSource::SEARCH);
+        stats.depth = static_cast<uint8_t>(result.depth);
+        stats.score = result.score;
+        stats.nodes = static_cast<uint32_t>(nodes);
+        return result.move;
+    }
+};
+
+int marbles(const AbaloneBoard& board, CellState player) {
+    int count = 0;
+    for (const Cell& cell : board.getBoard()) {
+        count += (cell.state == player) ? 1 : 0;
+    }
+    return count;
+}
+
+int main(int argc, char* argv[]) {
+    MatchOptions options;
+    GameRecordWriter recordWriter;
+    std::vector<std::string> engines;
+    for (int arg = 1; arg < argc; arg++) {
+        const std::string option = argv[arg];
+        if (option == "--games" && arg + 1 < argc) {
+            options.games = std::max(1, std::atoi(argv[++arg]));
+        } else if (option == "--time" && arg + 1 < argc) {
+            options.timeMs = std::max(0, std::atoi(argv[++arg]));
+        } else if (option == "--depth" && arg + 1 < argc) {
+            options.depth = std::max(1, std::atoi(argv[++arg]));
+        } else if (option == "--threads" && arg + 1 < argc) {
+            options.threads = std::max(1, std::atoi(argv[++arg]));
+        } else if (option == "--random-plies" && arg + 1 < argc) {
+            options.randomPlies = std::max(0, std::atoi(argv[++arg]));
+        } else if (option == "--max-plies" && arg + 1 < argc) {
+            options.maxPlies = std::max(1, std::atoi(argv[++arg]));
+        } else if (option == "--seed" && arg + 1 < argc) {
+            options.seed = std::strtoull(argv[++arg], nullptr, 10);
+        } else if (option == "--record" && arg + 1 < argc) {
+            if (!recordWriter.open(argv[++arg])) {
+                std::cerr << "Error: Could not open " << argv[arg] << std::endl;
+                return 1;
+            }
+        } else {
+            engines.push_back(option);
+        }
+    }
+    if (engines.size() != 2) {
+        std::cerr << "usage: match [--games n] [--time ms] [--depth n] [--threads n] [--random-plies n] "
+                     "[--max-plies n] [--seed n] [--record <file>] <engine A> <engine B>" << std::endl;
+        return 1;
+    }
+    if (options.timeMs == 0 && options.depth == 64) {
+        std::cerr << "Error: with --time 0 give alpha-beta a --depth" << std::endl;
+        return 1;
+    }
+    std::array<Player, 2> players;
+    for (int side = 0; side < 2; side++) {
+        if (!players[side].parse(engines[side], options)) {
+            return 1;
+        }
+    }
+
+    // points of A: a win is 1, a draw 0.5, an unfinished game counts for the side with more marbles (0.5 if level)
+    double pointsA = 0;
+    int winsA = 0;
+    int winsB = 0;
+    int draws = 0;
+    int unfinished = 0;
+    std::mt19937_64 random(options.seed);
+    for (int opening = 0; opening < options.games; opening++) {
+        const int layout = 1 + opening % 3;
+        const uint64_t openingSeed = random();
+        for (int swap = 0; swap < 2; swap++) {
+            const int blackPlayer = swap;  // index into players
+            AbaloneBoard board;
+            for (const auto& [pos, color] : parseBoardFromString(layoutString(layout))) {
+                board.setCellState(pos, color == 'b' ? CellState::BLACK : CellState::WHITE);
+            }
+            CellState toMove = CellState::BLACK;
+            GameHistory history;
+            history.reset(board, toMove);
+            recordWriter.beginGame(layout, toMove, 2, SearchParams(), true);
+
+            std::mt19937_64 openingRandom(openingSeed);
+            GameResult result = GameResult::NONE;
+            MoveList legalMoves;
+            int ply = 0;
+            for (; ply < options.maxPlies && result == GameResult::NONE; ply++) {
+                board.generateLegalMoves(toMove, legalMoves);
+                if (legalMoves.empty()) {
+                    result = (toMove == CellState::BLACK) ? GameResult::WHITE_WINS : GameResult::BLACK_WINS;
+                    break;
+                }
+                const auto start = std::chrono::steady_clock::now();
+                PlyRecord stats{};
+                std::string move;
+                if (ply < options.randomPlies) {
+                    move = legalMoves[openingRandom() % legalMoves.size()].str();
+                } else {
+                    Player& player = players[(toMove == CellState::BLACK) ? blackPlayer : 1 - blackPlayer];
+                    move = player.play(board, toMove, history, options, stats);
+                    if (!legalMoves.contains(Move(move))) {
+                        std::cerr << "Error: " << player.name << " played an illegal move \"" << move << "\""
+                                  << std::endl;
+                        return 1;
+                    }
+                }
+                stats.timeMs = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start).count());
+                recordWriter.addMove(move, stats);
+                board.makeMove(Move(move));
+                toMove = opponentOf(toMove);
+                history.add(board, toMove);
+                if (marbles(board, toMove) < 9) {
+                    result = (toMove == CellState::BLACK) ? GameResult::WHITE_WINS : GameResult::BLACK_WINS;
+                } else if (history.occurrences() >= REPETITION_DRAW) {
+                    result = GameResult::DRAW;
+                }
+            }
+            if (recordWriter.isOpen() && !recordWriter.finishGame(result)) {
+                std::cerr << "Warning: could not write the game record, recording stops" << std::endl;
+            }
+
+            const CellState sideA = (blackPlayer == 0) ? CellState::BLACK : CellState::WHITE;
+            const int balanceA = marbles(board, sideA) - marbles(board, opponentOf(sideA));
+            std::string outcome;
+            if (result == GameResult::NONE) {
+                unfinished++;
+                pointsA += (balanceA > 0) ? 1 : (balanceA < 0) ? 0 : 0.5;
+                outcome = "unfinished";
+            } else if (result == GameResult::DRAW) {
+                draws++;
+                pointsA += 0.5;
+                outcome = "draw by repetition";
+            } else if ((result == GameResult::BLACK_WINS) == (sideA == CellState::BLACK)) {
+                winsA++;
+                pointsA += 1;
+                outcome = players[0].name + " wins";
+            } else {
+                winsB++;
+                outcome = players[1].name + " wins";
+            }
+            std::cout << "Game " << 2 * opening + swap + 1 << ": layout " << layout << ", "
+                      << players[blackPlayer].name << " black, " << outcome << " after " << ply
+                      << " plies, marbles " << balanceA << " for " << players[0].name << std::endl;
+        }
+    }
+
+    const int games = 2 * options.games;
+    std::cout << players[0].name << " - " << players[1].name << ": " << winsA << " wins, " << winsB << " losses, "
+              << draws << " draws, " << unfinished << " unfinished; " << pointsA << "/" << games << " points ("
+              << (100.0 * pointsA / games) << "%)" << std::endl;
+    return 0;
+}
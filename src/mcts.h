@@ -0,0 +1,446 @@
+#ifndef ABALONE_MCTS_H
+#define ABALONE_MCTS_H
+
+#include "engine.h"
+#include "playout.h"
+
+#include <cmath>
+#include <memory>
+
+/*
+ * Monte Carlo tree search, the alternative to minimax. Each iteration walks down the tree by
+ * UCT (mean result plus an exploration bonus for rarely tried moves), expands the leaf it
+ * reaches into all of its moves, plays the game on from there with fast random moves
+ * (a playout), and adds the result to every node on the way back up.
+ *
+ * Playouts run on bitboards (playout.h). With pushBias they push (preferring push-offs)
+ * whenever a push is available in that share of plies, which ends playouts sooner and makes
+ * their results more telling than uniformly random play. A playout that reaches playoutPlies
+ * without a winner is scored by the two sides' evaluations, squashed to 0..1.
+ *
+ * Nodes come from a fixed pool in one array, children of a node in one contiguous block, so
+ * the tree needs no allocation while it searches. Between moves the subtree of the position
+ * actually reached is kept (tree reuse) and compacted into a second pool.
+ *
+ * Threads: TREE parallelism runs every thread on one shared tree; a playout counts its visit on
+ * the way down, so until its result arrives the path looks like a loss to the other threads
+ * (virtual loss) and they spread out over other moves. ROOT parallelism gives each thread a
+ * tree of its own and adds up the visits of the root moves at the end.
+ */
+
+enum class MctsParallelism { TREE, ROOT };
+
+struct MctsParams {
+    int timeMs = 1000;                  // think time per move, 0 for no limit
+    uint64_t playouts = 0;              // playouts per move over all threads, 0 for no limit
+    int threads = 1;
+    MctsParallelism parallelism = MctsParallelism::TREE;
+    double exploration = 0.7;           // UCT constant
+    int playoutPlies = 40;              // playouts stop here and are scored by the evaluation
+    int pushBias = 50;                  // percent of playout plies that push when a push is available
+    double evalScale = 0.003;           // an unfinished playout is worth sigmoid(evalScale * (Black's - White's evaluation))
+    size_t maxNodes = 1 << 20;          // node pool, shared by the trees of ROOT parallelism
+    bool reuseTree = true;
+    uint64_t seed = 1;
+    const std::atomic<bool>* stop = nullptr;  // set by another thread to end the search early
+};
+
+// result of an MCTS search: the most visited root move
+struct MctsResult {
+    std::string move;
+    double value = 0.5;     // mean playout result of the move for the side to move, 0..1
+    uint64_t playouts = 0;  // this search
+    uint64_t reused = 0;    // playouts inherited from the previous search's tree
+    size_t nodes = 0;       // nodes in the tree(s)
+    int64_t ms = 0;
+};
+
+class MctsTree {
+    // the side that played a node's move gets REWARD_ONE for a win, 0 for a loss
+    static constexpr uint64_t REWARD_ONE = 1 << 16;
+
+    enum NodeState : uint8_t { LEAF, EXPANDING, EXPANDED, GAME_OVER };
+
+    struct Node {
+        Move move;                                // the move that led here
+        std::atomic<uint32_t> visits{0};          // including playouts still on their way
+        std::atomic<uint64_t> reward{0};          // results for the side that played move
+        std::atomic<uint32_t> firstChild{0};
+        std::atomic<uint16_t> childCount{0};
+        std::atomic<uint8_t> state{LEAF};         // GAME_OVER: move won the game
+    };
+
+    std::unique_ptr<Node[]> nodes;
+    std::unique_ptr<Node[]> spare;  // the other pool, for compacting on reuse
+    size_t capacity;
+    std::atomic<size_t> used{0};
+    AbaloneBoard rootBoard;
+    CellState rootPlayer = CellState::BLACK;
+
+    static constexpr uint32_t ROOT = 0;
+
+    static int marbles(const AbaloneBoard& board, CellState player) {
+        int count = 0;
+        for (const Cell& cell : board.getBoard()) {
+            count += (cell.state == player) ? 1 : 0;
+        }
+        return count;
+    }
+
+    // take count nodes from the pool; returns the first, or -1 if the pool is full
+    int64_t allocate(size_t count) {
+        const size_t first = used.fetch_add(count, std::memory_order_relaxed);
+        if (first + count > capacity) {
+            return -1;
+        }
+        return static_cast<int64_t>(first);
+    }
+
+    static void initNode(Node& node, const Move& move) {
+        node.move = move;
+        node.visits.store(0, std::memory_order_relaxed);
+        node.reward.store(0, std::memory_order_relaxed);
+        node.firstChild.store(0, std::memory_order_relaxed);
+        node.childCount.store(0, std::memory_order_relaxed);
+        node.state.store(LEAF, std::memory_order_relaxed);
+    }
+
+    // give a leaf its children, pushes (push-offs first) ahead of the other moves so they are
+    // tried first; returns false if another thread is expanding it or the pool is full
+    template <CellState Us>
+    bool expand(Node& node, const AbaloneBoard& board) {
+        uint8_t expected = LEAF;
+        if (!node.state.compare_exchange_strong(expected, EXPANDING, std::memory_order_acquire)) {
+            return false;
+        }
+        thread_local MoveList moves;
+        thread_local MoveList pushMoves;
+        board.generateLegalMoves<Us>(moves);
+        pushMoves.clear();
+        board.generatePushMoves<Us>(pushMoves);
+        const int64_t first = allocate(moves.size());
+        if (moves.empty() || first < 0) {
+            node.state.store(LEAF, std::memory_order_release);
+            return false;
+        }
+        size_t next = static_cast<size_t>(first);
+        for (const bool pushes : {true, false}) {
+            for (const Move& move : moves) {
+                if (pushMoves.contains(move) == pushes) {
+                    initNode(nodes[next++], move);
+                }
+            }
+        }
+        node.firstChild.store(static_cast<uint32_t>(first), std::memory_order_relaxed);
+        node.childCount.store(static_cast<uint16_t>(moves.size()), std::memory_order_relaxed);
+        node.state.store(EXPANDED, std::memory_order_release);
+        return true;
+    }
+
+    // the child with the best UCT score; children never tried come first, in order
+    uint32_t selectChild(const Node& node, double exploration) const {
+        const uint32_t first = node.firstChild.load(std::memory_order_relaxed);
+        const uint32_t count = node.childCount.load(std::memory_order_relaxed);
+        const double logVisits = std::log(static_cast<double>(std::max<uint32_t>(1, node.visits.load(std::memory_order_relaxed))));
+        uint32_t best = first;
+        double bestScore = -1;
+        for (uint32_t child = first; child < first + count; child++) {
+            const uint32_t visits = nodes[child].visits.load(std::memory_order_relaxed);
+            if (visits == 0) {
+                return child;
+            }
+            const double mean = static_cast<double>(nodes[child].reward.load(std::memory_order_relaxed)) /
+                                (static_cast<double>(REWARD_ONE) * visits);
+            const double score = mean + exploration * std::sqrt(logVisits / visits);
+            if (score > bestScore) {
+                bestScore = score;
+                best = child;
+            }
+        }
+        return best;
+    }
+
+    // play on from board; returns Black's result, 0..1
+    static double playout(const AbaloneBoard& board, CellState toMove, PlayoutRandom& random, const MctsParams& params) {
+        PlayoutParams playoutParams;
+        playoutParams.maxPlies = params.playoutPlies;
+        playoutParams.pushBias = params.pushBias;
+        const PlayoutResult result = randomPlayout(PlayoutBoard(board), toMove, random, playoutParams);
+        if (result.winner != CellState::EMPTY) {
+            return (result.winner == CellState::BLACK) ? 1.0 : 0.0;
+        }
+        // the evaluation rates one side's marbles; the difference is 0 in a level position
+        const AbaloneBoard end = result.board.toBoard();
+        const double eval = evaluatePosition<CellState::BLACK>(end) - evaluatePosition<CellState::WHITE>(end);
+        return 1.0 / (1.0 + std::exp(-params.evalScale * eval));
+    }
+
+    bool expand(Node& node, const AbaloneBoard& board, CellState toMove) {
+        return (toMove == CellState::BLACK) ? expand<CellState::BLACK>(node, board)
+                                            : expand<CellState::WHITE>(node, board);
+    }
+
+public:
+    explicit MctsTree(size_t capacity)
+        : nodes(new Node[capacity]), spare(new Node[capacity]), capacity(capacity) {
+        reset(AbaloneBoard(), CellState::BLACK);
+    }
+
+    // forget the tree and start again from a position
+    void reset(const AbaloneBoard& board, CellState toMove) {
+        rootBoard = board;
+        rootPlayer = toMove;
+        used = 1;
+        initNode(nodes[ROOT], Move());
+    }
+
+    // Move the root to a position reached from it in one or two plies (our move, then the
+    // opponent's), keeping what was learnt about it; otherwise start again. Returns the playouts kept.
+    uint64_t advance(const AbaloneBoard& board, CellState toMove) {
+        const uint64_t key = hashBoard(board, toMove);
+        int64_t found = (hashBoard(rootBoard, rootPlayer) == key) ? int64_t(ROOT) : -1;
+        // breadth-first over the first two plies of the tree
+        std::vector<std::pair<uint32_t, int>> frontier = {{ROOT, 0}};
+        for (size_t i = 0; found < 0 && i < frontier.size(); i++) {
+            const auto [index, depth] = frontier[i];
+            const Node& node = nodes[index];
+            if (depth == 2 || node.state.load() != EXPANDED) {
+                continue;
+            }
+            const uint32_t first = node.firstChild.load();
+            for (uint32_t child = first; child < first + node.childCount.load(); child++) {
+                // replay the path to the child and compare positions
+                AbaloneBoard childBoard = rootBoard;
+                CellState childToMove = rootPlayer;
+                if (depth == 1) {
+                    childBoard.makeMove(nodes[index].move);
+                    childToMove = opponentOf(childToMove);
+                }
+                childBoard.makeMove(nodes[child].move);
+                childToMove = opponentOf(childToMove);
+                if (hashBoard(childBoard, childToMove) == key) {
+                    found = child;
+                    break;
+                }
+                frontier.emplace_back(child, depth + 1);
+            }
+        }
+        if (found < 0) {
+            reset(board, toMove);
+            return 0;
+        }
+        compact(static_cast<uint32_t>(found));
+        rootBoard = board;
+        rootPlayer = toMove;
+        return nodes[ROOT].visits.load();
+    }
+
+    // One iteration: select, expand, play out, back up. Safe to call from several threads at once.
+    void iterate(PlayoutRandom& random, const MctsParams& params) {
+        thread_local std::vector<uint32_t> path;
+        path.clear();
+        AbaloneBoard board = rootBoard;
+        CellState toMove = rootPlayer;
+        uint32_t index = ROOT;
+        nodes[ROOT].visits.fetch_add(1, std::memory_order_relaxed);
+        path.push_back(ROOT);
+
+        double blackResult = -1;
+        while (true) {
+            Node& node = nodes[index];
+            uint8_t state = node.state.load(std::memory_order_acquire);
+            if (state == GAME_OVER) {
+                // the last move won; it was played by the opponent of the side now to move
+                blackResult = (toMove == CellState::BLACK) ? 0.0 : 1.0;
+                break;
+            }
+            // a leaf is expanded on its second visit
+            if (state == LEAF && node.visits.load(std::memory_order_relaxed) > 1 && expand(node, board, toMove)) {
+                state = EXPANDED;
+            }
+            if (state != EXPANDED) {
+                break;
+            }
+            index = selectChild(node, params.exploration);
+            Node& child = nodes[index];
+            child.visits.fetch_add(1, std::memory_order_relaxed);  // virtual loss until the result is in
+            path.push_back(index);
+            board.makeMove(child.move);
+            toMove = opponentOf(toMove);
+            if (marbles(board, toMove) < 9) {
+                child.state.store(GAME_OVER, std::memory_order_release);
+            }
+        }
+        if (blackResult < 0) {
+            blackResult = playout(board, toMove, random, params);
+        }
+
+        // the root node's move was played by the opponent of the side to move there
+        CellState mover = opponentOf(rootPlayer);
+        const auto blackReward = static_cast<uint64_t>(std::lround(blackResult * REWARD_ONE));
+        for (const uint32_t node : path) {
+            nodes[node].reward.fetch_add(mover == CellState::BLACK ? blackReward : REWARD_ONE - blackReward,
+                                         std::memory_order_relaxed);
+            mover = opponentOf(mover);
+        }
+    }
+
+    [[nodiscard]] size_t size() const {
+        return std::min(used.load(), capacity);
+    }
+
+    [[nodiscard]] uint64_t rootVisits() const {
+        return nodes[ROOT].visits.load();
+    }
+
+    // the root moves with their visits and total reward (for the side to move at the root)
+    void rootMoves(std::vector<std::tuple<Move, uint64_t, uint64_t>>& moves) const {
+        if (nodes[ROOT].state.load() != EXPANDED) {
+            return;
+        }
+        const uint32_t first = nodes[ROOT].firstChild.load();
+        for (uint32_t child = first; child < first + nodes[ROOT].childCount.load(); child++) {
+            moves.emplace_back(nodes[child].move, nodes[child].visits.load(), nodes[child].reward.load());
+        }
+    }
+
+    static double rewardValue(uint64_t reward, uint64_t visits) {
+        return visits ? static_cast<double>(reward) / (static_cast<double>(REWARD_ONE) * visits) : 0.5;
+    }
+
+private:
+    // copy the subtree under newRoot into the spare pool, breadth first so every node's
+    // children stay in one block, and make it the tree
+    void compact(uint32_t newRoot) {
+        auto copy = [](const Node& from, Node& to) {
+            to.move = from.move;
+            to.visits.store(from.visits.load());
+            to.reward.store(from.reward.load());
+            to.childCount.store(from.childCount.load());
+            const uint8_t state = from.state.load();
+            to.state.store(state == EXPANDING ? static_cast<uint8_t>(LEAF) : state);
+        };
+        copy(nodes[newRoot], spare[ROOT]);
+        std::vector<std::pair<uint32_t, uint32_t>> queue = {{newRoot, ROOT}};  // old index, new index
+        size_t next = 1;
+        for (size_t i = 0; i < queue.size(); i++) {
+            const auto [from, to] = queue[i];
+            if (spare[to].state.load() != EXPANDED) {
+                continue;
+            }
+            const uint32_t first = nodes[from].firstChild.load();
+            const uint32_t count = nodes[from].childCount.load();
+            spare[to].firstChild.store(static_cast<uint32_t>(next));
+            for (uint32_t child = 0; child < count; child++) {
+                copy(nodes[first + child], spare[next + child]);
+                queue.emplace_back(first + child, static_cast<uint32_t>(next + child));
+            }
+            next += count;
+        }
+        std::swap(nodes, spare);
+        used = next;
+    }
+};
+
+// The MCTS player: its trees (one, or one per thread with ROOT parallelism) live from move to
+// move so the search can reuse them.
+class MctsEngine {
+    MctsParams params;
+    std::vector<std::unique_ptr<MctsTree>> trees;
+    uint64_t searches = 0;
+
+public:
+    explicit MctsEngine(const MctsParams& mctsParams) : params(mctsParams) {
+        const int threads = std::max(1, params.threads);
+        const size_t treeCount = (params.parallelism == MctsParallelism::ROOT) ? threads : 1;
+        for (size_t tree = 0; tree < treeCount; tree++) {
+            trees.push_back(std::make_unique<MctsTree>(params.maxNodes / treeCount));
+        }
+    }
+
+    [[nodiscard]] const MctsParams& settings() const {
+        return params;
+    }
+
+    MctsResult search(const AbaloneBoard& board, CellState toMove) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto deadline = start + std::chrono::milliseconds(params.timeMs);
+        MctsResult result;
+        for (const auto& tree : trees) {
+            if (params.reuseTree) {
+                result.reused += tree->advance(board, toMove);
+            } else {
+                tree->reset(board, toMove);
+            }
+        }
+
+        // threads share the playout budget; each checks the limits between playouts
+        std::atomic<uint64_t> playouts{0};
+        auto work = [&](MctsTree& tree, int thread) {
+            PlayoutRandom random(params.seed + 0x9E3779B97F4A7C15ULL * (searches * 64 + thread + 1));
+            while (true) {
+                if (params.playouts > 0 && playouts.fetch_add(1, std::memory_order_relaxed) >= params.playouts) {
+                    break;
+                }
+                if ((params.stop && params.stop->load(std::memory_order_relaxed)) ||
+                    (params.timeMs > 0 && std::chrono::steady_clock::now() >= deadline)) {
+                    break;
+                }
+                tree.iterate(random, params);
+                if (params.playouts == 0) {
+                    playouts.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        };
+        std::vector<std::thread> helpers;
+        const int threads = std::max(1, params.threads);
+        for (int thread = 1; thread < threads; thread++) {
+            MctsTree& tree = *trees[trees.size() == 1 ? 0 : thread];
+            helpers.emplace_back([&work, &tree, thread]() { work(tree, thread); });
+        }
+        work(*trees[0], 0);
+        for (std::thread& helper : helpers) {
+            helper.join();
+        }
+        searches++;
+
+        // the most visited move over all trees
+        std::vector<std::tuple<Move, uint64_t, uint64_t>> moves;
+        for (const auto& tree : trees) {
+            tree->rootMoves(moves);
+            result.nodes += tree->size();
+        }
+        std::vector<std::tuple<Move, uint64_t, uint64_t>> totals;
+        for (const auto& [move, visits, reward] : moves) {
+            auto total = std::find_if(totals.begin(), totals.end(),
+                                      [&move = move](const auto& entry) { return std::get<0>(entry) == move; });
+            if (total == totals.end()) {
+                totals.emplace_back(move, visits, reward);
+            } else {
+                std::get<1>(*total) += visits;
+                std::get<2>(*total) += reward;
+            }
+        }
+        uint64_t bestVisits = 0;
+        for (const auto& [move, visits, reward] : totals) {
+            if (result.move.empty() || visits > bestVisits) {
+                bestVisits = visits;
+                result.move = move.str();
+                result.value = MctsTree::rewardValue(reward, visits);
+            }
+        }
+        if (result.move.empty()) {
+            // not even the root was expanded (no time): any legal move
+            MoveList legalMoves;
+            board.generateLegalMoves(toMove, legalMoves);
+            if (!legalMoves.empty()) {
+                result.move = legalMoves[0].str();
+            }
+        }
+        result.playouts = std::min(playouts.load(), params.playouts > 0 ? params.playouts : UINT64_MAX);
+        result.ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+};
+
+#endif // ABALONE_MCTS_H
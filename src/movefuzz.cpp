@@ -0,0 +1,359 @@
+#include "engine.h"
+#include "playout.h"
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+
+/*
+ * Differential fuzzer for the move generator: plays random positions through the engine's
+ * generateLegalMoves, generatePushMoves, canPushOff, makeMove/unmakeMove (with the zobrist key
+ * they keep up to date), and the bitboard
+ * playout moves (playout.h), and compares them with a slow reference written straight from the
+ * rules, on plain (row, digit) coordinates.
+ * The evaluation terms the search computes from the cells (evaluationFeatures, evaluatePosition)
+ * are compared with the ones computed from the board string (boardStringFeatures, evaluateBoard),
+ * and the sum of the distances between a side's marbles (pairDistanceSum, behind cohesion)
+ * with the sum over every pair.
+ * Stops at the first difference and prints the position.
+ *
+ * usage: movefuzz [positions] [seed]
+ */
+
+namespace reference {
+
+using Coord = std::pair<int, int>;  // row (0 = A), digit
+using Position = std::array<CellState, 9 * 10>;  // indexed by row * 10 + digit, off-board entries stay empty
+
+const int DELTA[6][2] = {{1, 1}, {1, 0}, {0, 1}, {0, -1}, {-1, 0}, {-1, -1}};  // NE, NW, E, W, SE, SW
+
+bool onBoard(Coord c) {
+    const int row = c.first;
+    const int digit = c.second;
+    const int low = (row <= 4) ? 1 : row - 3;
+    const int high = (row <= 4) ? row + 5 : 9;
+    return row >= 0 && row <= 8 && digit >= low && digit <= high;
+}
+
+Coord step(Coord c, int dir) {
+    return {c.first + DELTA[dir][0], c.second + DELTA[dir][1]};
+}
+
+CellState& at(Position& position, Coord c) {
+    return position[c.first * 10 + c.second];
+}
+
+CellState at(const Position& position, Coord c) {
+    return onBoard(c) ? position[c.first * 10 + c.second] : CellState::EMPTY;
+}
+
+// every cell of the board, in name order
+const std::vector<Coord>& allCells() {
+    static const std::vector<Coord> cells = [] {
+        std::vector<Coord> result;
+        for (int row = 0; row < 9; row++) {
+            for (int digit = 1; digit <= 9; digit++) {
+                if (onBoard({row, digit})) result.push_back({row, digit});
+            }
+        }
+        return result;
+    }();
+    return cells;
+}
+
+// steps between two cells: a step changes row, digit or both by one in the same direction
+int distance(Coord a, Coord b) {
+    const int rows = a.first - b.first;
+    const int digits = a.second - b.second;
+    return (std::abs(rows) + std::abs(digits) + std::abs(rows - digits)) / 2;
+}
+
+std::string name(Coord c) {
+    return std::string(1, static_cast<char>('A' + c.first)) + static_cast<char>('0' + c.second);
+}
+
+struct Result {
+    std::string move;
+    Position after;
+    bool push = false;
+    bool pushOff = false;
+};
+
+// Every legal move of player with the position it leads to. A group is 1 to 3 of the player's
+// marbles in a line; it moves along its line if the cells ahead allow a move or sumito, or
+// sideways if every target cell is empty.
+std::vector<Result> legalMoves(const Position& position, CellState player) {
+    const CellState opponent = (player == CellState::BLACK) ? CellState::WHITE : CellState::BLACK;
+    std::vector<Result> results;
+    for (const Coord& start : allCells()) {
+        if (at(position, start) != player) continue;
+        for (int axis = 0; axis < 6; axis++) {
+            std::vector<Coord> group = {start};
+            for (int size = 1; size <= 3; size++) {
+                if (size > 1) {
+                    const Coord next = step(group.back(), axis);
+                    if (!onBoard(next) || at(position, next) != player) break;
+                    group.push_back(next);
+                }
+
+                // inline: the group moves towards axis, start is its rear marble
+                std::vector<Coord> pushed;
+                Coord ahead = step(group.back(), axis);
+                while (onBoard(ahead) && at(position, ahead) == opponent) {
+                    pushed.push_back(ahead);
+                    ahead = step(ahead, axis);
+                }
+                const bool blocked = onBoard(ahead) && at(position, ahead) == player;
+                const bool suicide = pushed.empty() && !onBoard(ahead);
+                if (!blocked && !suicide && pushed.size() < group.size()) {
+                    Result result;
+                    result.move = "i" + name(start) + directions[axis];
+                    result.after = position;
+                    for (const Coord& c : group) at(result.after, c) = CellState::EMPTY;
+                    for (const Coord& c : pushed) at(result.after, c) = CellState::EMPTY;
+                    for (const Coord& c : group) at(result.after, step(c, axis)) = player;
+                    for (const Coord& c : pushed) {
+                        if (onBoard(step(c, axis))) at(result.after, step(c, axis)) = opponent;
+                    }
+                    result.push = !pushed.empty();
+                    result.pushOff = result.push && !onBoard(ahead);
+                    results.push_back(result);
+                }
+
+                // sidestep: listed once per group, from the group's first cell in name order
+                if (size == 1 || name(start) > name(group.back())) continue;
+                for (int dir = 0; dir < 6; dir++) {
+                    if (dir == axis || dir == 5 - axis) continue;
+                    bool free = true;
+                    for (const Coord& c : group) {
+                        free = free && onBoard(step(c, dir)) && at(position, step(c, dir)) == CellState::EMPTY;
+                    }
+                    if (!free) continue;
+                    Result result;
+                    result.move = "s" + name(start) + name(group.back()) + directions[dir];
+                    result.after = position;
+                    for (const Coord& c : group) at(result.after, c) = CellState::EMPTY;
+                    for (const Coord& c : group) at(result.after, step(c, dir)) = player;
+                    results.push_back(result);
+                }
+            }
+        }
+    }
+    return results;
+}
+
+// same format as AbaloneBoard::boardToString
+std::string toString(const Position& position) {
+    std::string result;
+    for (const Coord& c : allCells()) {  // in name order
+        if (at(position, c) != CellState::EMPTY) {
+            result += name(c) + (at(position, c) == CellState::BLACK ? 'b' : 'w') + ",";
+        }
+    }
+    if (!result.empty()) result.pop_back();
+    return result;
+}
+
+} // namespace reference
+
+// random position: 1 to 14 marbles of each colour anywhere on the board
+reference::Position randomPosition(std::mt19937_64& random) {
+    std::vector<reference::Coord> cells = reference::allCells();
+    std::shuffle(cells.begin(), cells.end(), random);
+    const int black = 1 + static_cast<int>(random() % 14);
+    const int white = 1 + static_cast<int>(random() % 14);
+    reference::Position position{};
+    for (int i = 0; i < black + white; i++) {
+        reference::at(position, cells[i]) = (i < black) ? CellState::BLACK : CellState::WHITE;
+    }
+    return position;
+}
+
+// compare the engine with the reference on one position; returns a description of the first difference
+std::string checkPosition(const reference::Position& position, CellState player) {
+    // the engine's cells are found by name once, the comparisons below run for every move
+    static const std::vector<std::pair<reference::Coord, int>> cells = [] {
+        std::vector<std::pair<reference::Coord, int>> result;
+        for (const reference::Coord& c : reference::allCells()) {
+            result.emplace_back(c, cellIndex(reference::name(c)));
+        }
+        return result;
+    }();
+
+    AbaloneBoard board;
+    for (const reference::Coord& c : reference::allCells()) {
+        board.setCellState(reference::name(c), reference::at(position, c));
+    }
+
+    // the board's incremental key against one computed from scratch
+    auto keyIsRight = [&board]() {
+        uint64_t key = 0;
+        for (int index = 0; index < NUM_CELLS; index++) {
+            key ^= zobristKey(index, board.getBoard()[index].state);
+        }
+        return board.positionKey() == key;
+    };
+
+    // does the engine's board hold the same marbles as the reference position?
+    auto sameAs = [&board](const reference::Position& expected) {
+        for (const auto& [c, index] : cells) {
+            if (board.getBoard()[index].state != reference::at(expected, c)) return false;
+        }
+        return true;
+    };
+
+    std::map<std::string, const reference::Result*> expected;
+    const std::vector<reference::Result> results = reference::legalMoves(position, player);
+    for (const reference::Result& result : results) {
+        if (!expected.emplace(result.move, &result).second) {
+            return "reference lists " + result.move + " twice";
+        }
+    }
+
+    MoveList moves;
+    board.generateLegalMoves(player, moves);
+    std::set<std::string> seen;
+    for (const Move& move : moves) {
+        const std::string text = move.str();
+        if (!seen.insert(text).second) {
+            return "duplicate move " + text;
+        }
+        const auto it = expected.find(text);
+        if (it == expected.end()) {
+            return "illegal move " + text;
+        }
+        const MoveUndo undo = board.makeMove(move);
+        if (!sameAs(it->second->after)) {
+            return "wrong board after " + text + ": " + board.boardToString();
+        }
+        if (!keyIsRight() || undo.pushOff != it->second->pushOff) {
+            return "wrong key or push-off flag after " + text;
+        }
+        board.unmakeMove(undo);
+        if (!sameAs(position) || !keyIsRight()) {
+            return "unmakeMove of " + text + " leaves " + board.boardToString();
+        }
+    }
+    for (const auto& [text, result] : expected) {
+        if (!seen.count(text)) {
+            return "missing move " + text;
+        }
+    }
+
+    MoveList pushes;
+    const size_t pushOffCount = board.generatePushMoves(player, pushes);
+    std::set<std::string> pushSeen;
+    for (size_t i = 0; i < pushes.size(); i++) {
+        const std::string text = pushes[i].str();
+        const auto it = expected.find(text);
+        if (!pushSeen.insert(text).second || it == expected.end() || !it->second->push) {
+            return "bad push move " + text;
+        }
+        if (it->second->pushOff != (i < pushOffCount)) {
+            return "push-off moves not listed first: " + text;
+        }
+    }
+    size_t expectedPushOffs = 0;
+    for (const auto& [text, result] : expected) {
+        if (result->push && !pushSeen.count(text)) {
+            return "missing push move " + text;
+        }
+        expectedPushOffs += result->pushOff ? 1 : 0;
+    }
+    if (expectedPushOffs != pushOffCount || board.canPushOff(player) != (expectedPushOffs > 0)) {
+        return "wrong push-off count " + std::to_string(pushOffCount);
+    }
+
+    // the evaluation: the distances between the player's marbles (cohesion before it is
+    // divided by the number of marbles), every term, then the weighted score
+    CellMask own = 0;
+    std::vector<reference::Coord> ownCells;
+    for (const auto& [c, index] : cells) {
+        if (reference::at(position, c) == player) {
+            own |= CellMask(1) << index;
+            ownCells.push_back(c);
+        }
+    }
+    int pairDistances = 0;
+    for (size_t i = 0; i < ownCells.size(); i++) {
+        for (size_t j = i + 1; j < ownCells.size(); j++) {
+            pairDistances += reference::distance(ownCells[i], ownCells[j]);
+        }
+    }
+    if (pairDistanceSum(own) != pairDistances) {
+        return "pair distance sum " + std::to_string(pairDistanceSum(own)) + ", expected " + std::to_string(pairDistances);
+    }
+    const std::string boardString = reference::toString(position);
+    const std::array<int, EVAL_FEATURE_COUNT> features = (player == CellState::BLACK)
+                                                             ? evaluationFeatures<CellState::BLACK>(board)
+                                                             : evaluationFeatures<CellState::WHITE>(board);
+    const std::array<int, EVAL_FEATURE_COUNT> expectedFeatures = boardStringFeatures(boardString, player);
+    for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+        if (features[feature] != expectedFeatures[feature]) {
+            return std::string("evaluation term ") + EVAL_FEATURE_NAMES[feature] + " is " +
+                   std::to_string(features[feature]) + ", expected " + std::to_string(expectedFeatures[feature]);
+        }
+    }
+    const int score = (player == CellState::BLACK) ? evaluatePosition<CellState::BLACK>(board)
+                                                   : evaluatePosition<CellState::WHITE>(board);
+    if (score != evaluateBoard(boardString, player)) {
+        return "evaluation " + std::to_string(score) + ", expected " + std::to_string(evaluateBoard(boardString, player));
+    }
+
+    // the playout kernel: the same moves, counted by kind, and the same positions after them
+    const PlayoutBoard masks(board);
+    PlayoutMoves playoutMoves;
+    playoutMoves.generate(masks.marbles[sideIndex(player)], masks.marbles[1 - sideIndex(player)]);
+    if (playoutMoves.total != static_cast<int>(expected.size()) || playoutMoves.pushes != static_cast<int>(pushes.size()) ||
+        playoutMoves.pushOffs != static_cast<int>(pushOffCount)) {
+        return "playout move counts " + std::to_string(playoutMoves.total) + ", " + std::to_string(playoutMoves.pushes) +
+               " pushes, " + std::to_string(playoutMoves.pushOffs) + " push-offs";
+    }
+    std::set<std::string> playoutSeen;
+    for (int i = 0; i < playoutMoves.total; i++) {
+        const PlayoutMove move = playoutMoves.at(i);
+        const std::string text = move.move().str();
+        const auto it = expected.find(text);
+        if (!playoutSeen.insert(text).second || it == expected.end() ||
+            it->second->push != (i < playoutMoves.pushes) || it->second->pushOff != (i < playoutMoves.pushOffs)) {
+            return "bad playout move " + text;
+        }
+        PlayoutBoard after = masks;
+        playPlayoutMove(after, sideIndex(player), move);
+        for (const auto& [c, index] : cells) {
+            const CellState state = ((after.marbles[0] >> index) & 1) ? CellState::BLACK
+                                    : ((after.marbles[1] >> index) & 1) ? CellState::WHITE : CellState::EMPTY;
+            if (state != reference::at(it->second->after, c) || (after.marbles[0] & after.marbles[1]) != 0) {
+                return "wrong playout board after " + text;
+            }
+        }
+    }
+    return "";
+}
+
+int main(int argc, char* argv[]) {
+    const long long positions = (argc > 1) ? std::atoll(argv[1]) : 1000000;
+    const unsigned long long seed = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 1;
+    if (positions < 1) {
+        std::cerr << "usage: movefuzz [positions >= 1] [seed]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937_64 random(seed);
+    for (long long i = 0; i < positions; i++) {
+        const reference::Position position = randomPosition(random);
+        for (const CellState player : {CellState::BLACK, CellState::WHITE}) {
+            if (const std::string error = checkPosition(position, player); !error.empty()) {
+                std::cerr << "Position " << i << ", " << (player == CellState::BLACK ? "black" : "white")
+                          << " to move: " << reference::toString(position) << "\n" << error << std::endl;
+                return 1;
+            }
+        }
+        if ((i + 1) % 100000 == 0) {
+            std::cout << (i + 1) << " positions checked" << std::endl;
+        }
+    }
+    std::cout << "No differences in " << positions << " positions (seed " << seed << ")" << std::endl;
+    return 0;
+}
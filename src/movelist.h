@@ -0,0 +1,150 @@
+#ifndef ABALONE_MOVELIST_H
+#define ABALONE_MOVELIST_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// A move in the usual text form ("iC5NE", "sA1A3NW"), stored inline: no move is longer
+// than 7 characters, so it fits in 8 bytes and copies like an integer.
+class Move {
+    std::array<char, 8> text{};  // NUL-padded
+
+public:
+    Move() = default;
+
+    explicit Move(std::string_view move) {
+        std::memcpy(text.data(), move.data(), std::min(move.size(), text.size() - 1));
+    }
+
+    // build from parts, e.g. Move('i', "C5", "NE") or Move('s', "A1", "A3", "NW")
+    Move(char type, std::string_view pos, std::string_view dir) {
+        text[0] = type;
+        append(1, pos);
+        append(1 + pos.size(), dir);
+    }
+
+    Move(char type, std::string_view pos1, std::string_view pos2, std::string_view dir) {
+        text[0] = type;
+        append(1, pos1);
+        append(1 + pos1.size(), pos2);
+        append(1 + pos1.size() + pos2.size(), dir);
+    }
+
+    [[nodiscard]] bool empty() const {
+        return text[0] == '\0';
+    }
+
+    [[nodiscard]] std::string_view view() const {
+        return {text.data(), strnlen(text.data(), text.size())};
+    }
+
+    [[nodiscard]] std::string str() const {
+        return std::string(view());
+    }
+
+    bool operator==(const Move& other) const {
+        return text == other.text;
+    }
+
+    bool operator!=(const Move& other) const {
+        return text != other.text;
+    }
+
+private:
+    void append(size_t at, std::string_view part) {
+        if (at < text.size() - 1) {
+            std::memcpy(text.data() + at, part.data(), std::min(part.size(), text.size() - 1 - at));
+        }
+    }
+};
+
+// Upper bound on the moves generateLegalMoves can produce: with 14 marbles there are at most
+// 14 * 6 single, double and triple inline moves each, and 42 pairs and 42 lines of three (one
+// per marble and axis) with 4 sidestep directions each, the 6 directions less the line's own two.
+const size_t MAX_LEGAL_MOVES = 14 * 6 * 3 + 42 * 4 + 42 * 4;
+
+// Fixed-capacity move list with inline storage, so generating moves never touches the heap.
+// Each move has a score slot for move ordering; selectBest sorts lazily, one move at a time,
+// so a node that cuts off early doesn't pay for ordering the moves it never searches.
+class MoveList {
+    std::array<Move, MAX_LEGAL_MOVES> moves;
+    std::array<int, MAX_LEGAL_MOVES> scores{};
+    size_t count = 0;
+
+public:
+    void clear() {
+        count = 0;
+    }
+
+    // the list never fills up on a board with at most 14 marbles a side (see MAX_LEGAL_MOVES);
+    // boards from outside are checked for that (hasValidMarbleCounts)
+    void push_back(const Move& move) {
+        assert(count < MAX_LEGAL_MOVES);
+        scores[count] = 0;
+        moves[count++] = move;
+    }
+
+    // insert before position index, shifting the later moves back
+    void insert(size_t index, const Move& move) {
+        assert(count < MAX_LEGAL_MOVES);
+        for (size_t i = count; i > index; i--) {
+            moves[i] = moves[i - 1];
+            scores[i] = scores[i - 1];
+        }
+        moves[index] = move;
+        scores[index] = 0;
+        count++;
+    }
+
+    [[nodiscard]] size_t size() const {
+        return count;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return count == 0;
+    }
+
+    const Move& operator[](size_t index) const {
+        return moves[index];
+    }
+
+    int& score(size_t index) {
+        return scores[index];
+    }
+
+    [[nodiscard]] const Move* begin() const {
+        return moves.data();
+    }
+
+    [[nodiscard]] const Move* end() const {
+        return moves.data() + count;
+    }
+
+    [[nodiscard]] bool contains(const Move& move) const {
+        for (size_t i = 0; i < count; i++) {
+            if (moves[i] == move) return true;
+        }
+        return false;
+    }
+
+    // Partial selection sort: bring the highest-scored of the moves from index on to index.
+    // It is shifted forward rather than swapped, and the first of equal scores wins, so the
+    // order is stable: quiet moves are searched in generation order.
+    void selectBest(size_t index) {
+        size_t best = index;
+        for (size_t i = index + 1; i < count; i++) {
+            if (scores[i] > scores[best]) best = i;
+        }
+        if (best != index) {
+            std::rotate(moves.begin() + index, moves.begin() + best, moves.begin() + best + 1);
+            std::rotate(scores.begin() + index, scores.begin() + best, scores.begin() + best + 1);
+        }
+    }
+};
+
+#endif // ABALONE_MOVELIST_H
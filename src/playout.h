@@ -0,0 +1,356 @@
+#ifndef ABALONE_PLAYOUT_H
+#define ABALONE_PLAYOUT_H
+
+#include "engine.h"
+
+#include <thread>
+#include <vector>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+/*
+ * Random playouts on bitboards: play a game on from a position with random legal moves until
+ * a side is down to 8 marbles (six pushed off) or a ply limit, as fast as possible. MCTS and
+ * the playout statistics (game length and results per opening) are bound by playouts per second.
+ *
+ * No move list is built. Every legal move is the first marble of its line (the tail of an
+ * inline move, the lowest cell of a sidestep) in one of PLAYOUT_MOVE_CLASS_COUNT classes
+ * (direction, line length, marbles pushed); the legal moves of a class are one mask, computed
+ * with shifts from the two sides' masks. A random move is a random index into the classes'
+ * popcounts, and playing it updates the two masks.
+ *
+ * The classes are ordered push-offs, then the other pushes, then everything else, so a move can
+ * be drawn from the push-offs or the pushes alone (pushBias) as cheaply as from all moves.
+ */
+
+// one class of moves: the marbles of the line all step in dir
+struct PlayoutMoveClass {
+    int8_t axis;     // sidesteps: the direction the line runs in from its lowest cell (NE, NW or E); -1 inline
+    uint8_t dir;
+    uint8_t size;    // marbles in the line
+    uint8_t pushed;  // opponent marbles pushed (inline moves)
+};
+
+constexpr int PLAYOUT_PUSH_OFFS = 0;    // inline push-offs: dir * 3 + (2 on 1, 3 on 1, 3 on 2)
+constexpr int PLAYOUT_PUSHES = 18;      // pushes that stay on the board, in the same order
+constexpr int PLAYOUT_STEPS = 36;       // inline moves into an empty cell: dir * 3 + size - 1
+constexpr int PLAYOUT_SIDESTEPS = 54;   // axis * 8 + side direction (of the 4 off the axis) * 2 + size - 2
+constexpr int PLAYOUT_MOVE_CLASS_COUNT = 78;
+
+// the 4 directions a line along axis can sidestep in, numbered in direction order
+constexpr int sidestepSlot(int axis, int dir) {
+    return dir - (dir > axis ? 1 : 0) - (dir > DIRECTION_COUNT - 1 - axis ? 1 : 0);
+}
+
+constexpr std::array<PlayoutMoveClass, PLAYOUT_MOVE_CLASS_COUNT> PLAYOUT_MOVE_CLASSES = [] {
+    std::array<PlayoutMoveClass, PLAYOUT_MOVE_CLASS_COUNT> classes{};
+    constexpr uint8_t PUSH_SIZES[3][2] = {{2, 1}, {3, 1}, {3, 2}};  // size, pushed
+    for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+        for (int kind = 0; kind < 3; kind++) {
+            const auto d = static_cast<uint8_t>(dir);
+            classes[PLAYOUT_PUSH_OFFS + dir * 3 + kind] = {-1, d, PUSH_SIZES[kind][0], PUSH_SIZES[kind][1]};
+            classes[PLAYOUT_PUSHES + dir * 3 + kind] = {-1, d, PUSH_SIZES[kind][0], PUSH_SIZES[kind][1]};
+            classes[PLAYOUT_STEPS + dir * 3 + kind] = {-1, d, static_cast<uint8_t>(kind + 1), 0};
+        }
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+            if (dir == axis || dir == DIRECTION_COUNT - 1 - axis) {
+                continue;
+            }
+            for (int size = 2; size <= 3; size++) {
+                classes[PLAYOUT_SIDESTEPS + axis * 8 + sidestepSlot(axis, dir) * 2 + size - 2] = {
+                    static_cast<int8_t>(axis), static_cast<uint8_t>(dir), static_cast<uint8_t>(size), 0};
+            }
+        }
+    }
+    return classes;
+}();
+
+// the cell of the n-th (from 0) set bit of mask
+inline int nthCell(CellMask mask, int n) {
+#ifdef __BMI2__
+    return lowestCell(_pdep_u64(CellMask(1) << n, mask));
+#else
+    for (; n > 0; n--) {
+        mask &= mask - 1;
+    }
+    return lowestCell(mask);
+#endif
+}
+
+// a position as one mask per side
+struct PlayoutBoard {
+    std::array<CellMask, 2> marbles{};  // [0] Black, [1] White
+
+    PlayoutBoard() = default;
+
+    explicit PlayoutBoard(const AbaloneBoard& board) {
+        const auto& cells = board.getBoard();
+        for (int index = 0; index < NUM_CELLS; index++) {
+            marbles[0] |= CellMask(cells[index].state == CellState::BLACK) << index;
+            marbles[1] |= CellMask(cells[index].state == CellState::WHITE) << index;
+        }
+    }
+
+    [[nodiscard]] AbaloneBoard toBoard() const {
+        AbaloneBoard board;
+        for (int index = 0; index < NUM_CELLS; index++) {
+            board.setCellState(index, ((marbles[0] >> index) & 1) ? CellState::BLACK
+                                      : ((marbles[1] >> index) & 1) ? CellState::WHITE : CellState::EMPTY);
+        }
+        return board;
+    }
+};
+
+constexpr int sideIndex(CellState player) {
+    return (player == CellState::BLACK) ? 0 : 1;
+}
+
+// a legal move: its class and the first marble of its line
+struct PlayoutMove {
+    int moveClass = 0;
+    int cell = 0;
+
+    // the usual text form, as generateLegalMoves lists it
+    [[nodiscard]] Move move() const {
+        const PlayoutMoveClass& kind = PLAYOUT_MOVE_CLASSES[moveClass];
+        if (kind.axis < 0) {
+            return Move('i', cellNames[cell], directions[kind.dir]);
+        }
+        int last = cell;
+        for (int i = 1; i < kind.size; i++) {
+            last = boardGeometry.neighbour[last][kind.axis];
+        }
+        return Move('s', cellNames[cell], cellNames[last], directions[kind.dir]);
+    }
+};
+
+// every legal move of the side with the marbles own, as one mask per class
+struct PlayoutMoves {
+    std::array<CellMask, PLAYOUT_MOVE_CLASS_COUNT> cells{};
+    std::array<uint8_t, PLAYOUT_MOVE_CLASS_COUNT> counts{};  // popCount of each class
+    int pushOffs = 0;  // moves in the push-off classes
+    int pushes = 0;    // in the push classes, push-offs included
+    int total = 0;
+
+    void generate(CellMask own, CellMask opponent) {
+        const CellMask empty = ALL_CELLS & ~own & ~opponent;
+        forEachDirection([&](auto dir) {
+            constexpr int Dir = decltype(dir)::value;
+            // the cells whose neighbour in Dir is one of cells
+            const auto behind = [](CellMask cells) { return shiftCells<DIRECTION_COUNT - 1 - Dir>(cells); };
+            const CellMask ownAhead = behind(own);
+            const CellMask line2 = own & ownAhead;  // tails of two of ours in a row
+            const CellMask line3 = line2 & behind(ownAhead);
+            const CellMask emptyAhead = behind(empty);
+            // opponent marbles with the edge of the board or an empty cell in front: one can be
+            // pushed off or on, and two in a row likewise (off2, onto2 are the back marble)
+            const CellMask off1 = opponent & directionShifts[Dir].edge;
+            const CellMask onto1 = opponent & emptyAhead;
+            const CellMask off2 = opponent & behind(off1);
+            const CellMask onto2 = opponent & behind(onto1);
+            const CellMask off1Behind2 = behind(behind(off1));
+            const CellMask onto1Behind2 = behind(behind(onto1));
+            CellMask* pushOff = &cells[PLAYOUT_PUSH_OFFS + Dir * 3];
+            pushOff[0] = line2 & off1Behind2;
+            pushOff[1] = line3 & behind(off1Behind2);
+            pushOff[2] = line3 & behind(behind(behind(off2)));
+            CellMask* push = &cells[PLAYOUT_PUSHES + Dir * 3];
+            push[0] = line2 & onto1Behind2;
+            push[1] = line3 & behind(onto1Behind2);
+            push[2] = line3 & behind(behind(behind(onto2)));
+            CellMask* step = &cells[PLAYOUT_STEPS + Dir * 3];
+            const CellMask emptyAhead2 = behind(emptyAhead);
+            step[0] = own & emptyAhead;
+            step[1] = line2 & emptyAhead2;
+            step[2] = line3 & behind(emptyAhead2);
+        });
+        forEachDirection<3>([&](auto axis) {
+            constexpr int Axis = decltype(axis)::value;
+            const auto behind = [](CellMask cells) { return shiftCells<DIRECTION_COUNT - 1 - Axis>(cells); };
+            const CellMask ownAhead = behind(own);
+            const CellMask pairs = own & ownAhead;
+            const CellMask triples = pairs & behind(ownAhead);
+            forEachDirection([&](auto side) {
+                constexpr int Side = decltype(side)::value;
+                if constexpr (Side != Axis && Side != DIRECTION_COUNT - 1 - Axis) {
+                    const CellMask free = shiftCells<DIRECTION_COUNT - 1 - Side>(empty);  // empty neighbour to Side
+                    const CellMask freeAhead = behind(free);
+                    CellMask* sidestep = &cells[PLAYOUT_SIDESTEPS + Axis * 8 + sidestepSlot(Axis, Side) * 2];
+                    sidestep[0] = pairs & free & freeAhead;
+                    sidestep[1] = triples & free & freeAhead & behind(freeAhead);
+                }
+            });
+        });
+        total = 0;
+        for (int moveClass = 0; moveClass < PLAYOUT_MOVE_CLASS_COUNT; moveClass++) {
+            counts[moveClass] = static_cast<uint8_t>(popCount(cells[moveClass]));
+            total += counts[moveClass];
+            pushOffs = (moveClass == PLAYOUT_PUSHES - 1) ? total : pushOffs;
+            pushes = (moveClass == PLAYOUT_STEPS - 1) ? total : pushes;
+        }
+    }
+
+    // the index-th move, counting from the first class (index < total)
+    [[nodiscard]] PlayoutMove at(int index) const {
+        int moveClass = 0;
+        while (index >= counts[moveClass]) {
+            index -= counts[moveClass++];
+        }
+        return {moveClass, nthCell(cells[moveClass], index)};
+    }
+};
+
+// play a legal move of the side with index side (see sideIndex)
+inline void playPlayoutMove(PlayoutBoard& board, int side, const PlayoutMove& move) {
+    const PlayoutMoveClass& kind = PLAYOUT_MOVE_CLASSES[move.moveClass];
+    CellMask& own = board.marbles[side];
+    CellMask& opponent = board.marbles[1 - side];
+    if (kind.axis < 0) {
+        // the tail marble goes to the cell in front of the line, the first pushed marble (if
+        // any) to the cell in front of the pushed ones, unless that is off the board
+        int head = move.cell;
+        for (int i = 0; i < kind.size; i++) {
+            head = boardGeometry.neighbour[head][kind.dir];
+        }
+        own ^= (CellMask(1) << move.cell) | (CellMask(1) << head);
+        if (kind.pushed > 0) {
+            int end = head;
+            for (int i = 0; i < kind.pushed && end >= 0; i++) {
+                end = boardGeometry.neighbour[end][kind.dir];
+            }
+            opponent ^= CellMask(1) << head;
+            if (end >= 0) {
+                opponent |= CellMask(1) << end;
+            }
+        }
+        return;
+    }
+    CellMask from = 0;
+    CellMask to = 0;
+    for (int i = 0, cell = move.cell; i < kind.size; i++, cell = boardGeometry.neighbour[cell][kind.axis]) {
+        from |= CellMask(1) << cell;
+        to |= CellMask(1) << boardGeometry.neighbour[cell][kind.dir];
+    }
+    own = (own & ~from) | to;
+}
+
+// xorshift64*: a few instructions per number, plenty for choosing random moves
+class PlayoutRandom {
+    uint64_t state;
+
+public:
+    explicit PlayoutRandom(uint64_t seed) : state(splitMix64(seed) | 1) {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // uniform in [0, n) for n < 2^32
+    int below(int n) {
+        return static_cast<int>(((next() >> 32) * static_cast<uint64_t>(n)) >> 32);
+    }
+};
+
+struct PlayoutParams {
+    int maxPlies = 1000;  // the playout stops unfinished after this many plies
+    int pushBias = 0;     // percent of plies that push (a push-off if there is one) when a push is available
+};
+
+struct PlayoutResult {
+    CellState winner = CellState::EMPTY;  // EMPTY: stopped at maxPlies
+    int plies = 0;
+    PlayoutBoard board;                   // the final position
+};
+
+// Play on from board, toMove to move. A side with no legal move loses (as in MCTS), a side
+// down to 8 marbles has lost.
+inline PlayoutResult randomPlayout(const PlayoutBoard& board, CellState toMove, PlayoutRandom& random,
+                                   const PlayoutParams& params) {
+    PlayoutResult result;
+    result.board = board;
+    PlayoutMoves moves;
+    int side = sideIndex(toMove);
+    for (; result.plies < params.maxPlies; result.plies++) {
+        moves.generate(result.board.marbles[side], result.board.marbles[1 - side]);
+        if (moves.total == 0) {
+            result.winner = (side == 0) ? CellState::WHITE : CellState::BLACK;
+            break;
+        }
+        int choices = moves.total;
+        if (params.pushBias > 0 && moves.pushes > 0 && random.below(100) < params.pushBias) {
+            choices = (moves.pushOffs > 0) ? moves.pushOffs : moves.pushes;
+        }
+        playPlayoutMove(result.board, side, moves.at(random.below(choices)));
+        if (popCount(result.board.marbles[1 - side]) < 9) {
+            result.winner = (side == 0) ? CellState::BLACK : CellState::WHITE;
+            result.plies++;
+            break;
+        }
+        side = 1 - side;
+    }
+    return result;
+}
+
+// results of a batch of playouts
+struct PlayoutStats {
+    uint64_t playouts = 0;
+    uint64_t blackWins = 0;
+    uint64_t whiteWins = 0;
+    uint64_t plies = 0;         // over all playouts
+    uint64_t decidedPlies = 0;  // over the playouts with a winner
+
+    PlayoutStats& operator+=(const PlayoutStats& other) {
+        playouts += other.playouts;
+        blackWins += other.blackWins;
+        whiteWins += other.whiteWins;
+        plies += other.plies;
+        decidedPlies += other.decidedPlies;
+        return *this;
+    }
+
+    void add(const PlayoutResult& result) {
+        playouts++;
+        blackWins += (result.winner == CellState::BLACK) ? 1 : 0;
+        whiteWins += (result.winner == CellState::WHITE) ? 1 : 0;
+        plies += result.plies;
+        decidedPlies += (result.winner != CellState::EMPTY) ? result.plies : 0;
+    }
+};
+
+// Run count independent playouts from one position on threads threads. Playout i draws its
+// moves from seed and i alone, so the totals don't depend on the number of threads.
+inline PlayoutStats runPlayouts(const PlayoutBoard& board, CellState toMove, uint64_t count, int threads,
+                                const PlayoutParams& params, uint64_t seed) {
+    threads = static_cast<int>(std::max<uint64_t>(1, std::min<uint64_t>(threads, count)));
+    std::vector<PlayoutStats> partial(threads);
+    auto work = [&](int thread) {
+        PlayoutStats stats;  // local, so threads don't share cache lines while they run
+        for (uint64_t i = thread; i < count; i += threads) {
+            PlayoutRandom random(seed ^ (0x9E3779B97F4A7C15ULL * (i + 1)));
+            stats.add(randomPlayout(board, toMove, random, params));
+        }
+        partial[thread] = stats;
+    };
+    std::vector<std::thread> helpers;
+    for (int thread = 1; thread < threads; thread++) {
+        helpers.emplace_back(work, thread);
+    }
+    work(0);
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+    PlayoutStats total;
+    for (const PlayoutStats& stats : partial) {
+        total += stats;
+    }
+    return total;
+}
+
+#endif // ABALONE_PLAYOUT_H
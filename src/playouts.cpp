@@ -0,0 +1,70 @@
+#include "engine.h"
+#include "playout.h"
+
+#include <iomanip>
+#include <iostream>
+
+/*
+ * Random playout statistics per opening: from each standard layout, play random games (see
+ * playout.h) and report how they end and how long they take, and the playout rate.
+ *
+ * usage: playouts [--count n] [--threads n] [--max-plies n] [--push-bias percent] [--layout n] [--seed n]
+ *   --count n     playouts per layout (default 100000)
+ *   --layout n    only this layout (1 Default, 2 German, 3 Belgian; default all three)
+ *   --push-bias   as MctsParams::pushBias (default 0: uniformly random moves)
+ */
+
+int main(int argc, char* argv[]) {
+    uint64_t count = 100000;
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int firstLayout = 1;
+    int lastLayout = 3;
+    uint64_t seed = 1;
+    PlayoutParams params;
+    for (int arg = 1; arg < argc; arg++) {
+        const std::string option = argv[arg];
+        if (option == "--count" && arg + 1 < argc) {
+            count = std::max<uint64_t>(1, std::strtoull(argv[++arg], nullptr, 10));
+        } else if (option == "--threads" && arg + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++arg]));
+        } else if (option == "--max-plies" && arg + 1 < argc) {
+            params.maxPlies = std::max(1, std::atoi(argv[++arg]));
+        } else if (option == "--push-bias" && arg + 1 < argc) {
+            params.pushBias = std::clamp(std::atoi(argv[++arg]), 0, 100);
+        } else if (option == "--layout" && arg + 1 < argc) {
+            firstLayout = lastLayout = std::clamp(std::atoi(argv[++arg]), 1, 3);
+        } else if (option == "--seed" && arg + 1 < argc) {
+            seed = std::strtoull(argv[++arg], nullptr, 10);
+        } else {
+            std::cerr << "usage: playouts [--count n] [--threads n] [--max-plies n] [--push-bias percent] "
+                         "[--layout n] [--seed n]" << std::endl;
+            return 1;
+        }
+    }
+
+    static const char* const LAYOUT_NAMES[] = {"Default", "German", "Belgian"};
+    std::cout << std::fixed << std::setprecision(1);
+    for (int layout = firstLayout; layout <= lastLayout; layout++) {
+        AbaloneBoard board;
+        for (const auto& [pos, color] : parseBoardFromString(layoutString(layout))) {
+            board.setCellState(pos, color == 'b' ? CellState::BLACK : CellState::WHITE);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        const PlayoutStats stats = runPlayouts(PlayoutBoard(board), CellState::BLACK, count, threads, params, seed);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const auto percent = [&stats](uint64_t part) { return 100.0 * static_cast<double>(part) / stats.playouts; };
+        const uint64_t decided = stats.blackWins + stats.whiteWins;
+        std::cout << LAYOUT_NAMES[layout - 1] << ": " << stats.playouts << " playouts, black wins " << percent(stats.blackWins)
+                  << "%, white wins " << percent(stats.whiteWins) << "%, unfinished "
+                  << percent(stats.playouts - decided) << "%; average length "
+                  << static_cast<double>(stats.plies) / stats.playouts << " plies";
+        if (decided > 0) {
+            std::cout << " (decided games " << static_cast<double>(stats.decidedPlies) / decided << ")";
+        }
+        std::cout << "; " << std::setprecision(0) << stats.playouts / seconds << " playouts/s, "
+                  << static_cast<double>(stats.plies) / seconds << " plies/s on " << threads << " threads"
+                  << std::setprecision(1) << std::endl;
+    }
+    return 0;
+}
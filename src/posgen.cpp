@@ -0,0 +1,111 @@
+#include "engine.h"
+
+#include <iostream>
+#include <fstream>
+#include <random>
+
+/*
+ * Generate a reproducible corpus of random positions for benchmarks and stress tests. Every
+ * position is reached by random legal moves from one of the three standard layouts (Black
+ * moving first), after a random number of plies, so the corpus covers openings through
+ * endgames. Pushes are played more often than a uniform choice would, so marbles actually
+ * leave the board; games stop before either side is down to 8 marbles (the game is over then).
+ *
+ * Positions are written as consecutive records in the input file format: the side to move on
+ * one line, the marbles on the next. Only the seed decides the output (random numbers are
+ * drawn straight from mt19937_64, whose sequence the standard fixes).
+ *
+ * usage: posgen [positions] [seed] [output file] [max plies]
+ */
+
+struct PositionGenerator {
+    std::mt19937_64 random;
+    int maxPlies;
+
+    int below(int n) {
+        return static_cast<int>(random() % static_cast<uint64_t>(n));
+    }
+
+    static int marbles(const AbaloneBoard& board, CellState player) {
+        int count = 0;
+        for (const Cell& cell : board.getBoard()) {
+            count += (cell.state == player) ? 1 : 0;
+        }
+        return count;
+    }
+
+    // one position: a layout and a game of random moves, stopped after a random number of plies
+    std::pair<AbaloneBoard, CellState> next() {
+        AbaloneBoard board;
+        for (const auto& [pos, color] : parseBoardFromString(layoutString(1 + below(3)))) {
+            board.setCellState(pos, color == 'b' ? CellState::BLACK : CellState::WHITE);
+        }
+        CellState toMove = CellState::BLACK;
+        const int plies = below(maxPlies + 1);
+
+        MoveList legalMoves;
+        MoveList pushMoves;
+        for (int ply = 0; ply < plies; ply++) {
+            board.generateLegalMoves(toMove, legalMoves);
+            if (legalMoves.empty()) {
+                break;
+            }
+            pushMoves.clear();
+            const int pushOffCount = static_cast<int>(board.generatePushMoves(toMove, pushMoves));
+
+            // half the time push if we can, preferring pushes that knock a marble off
+            Move move = legalMoves[below(static_cast<int>(legalMoves.size()))];
+            if (!pushMoves.empty() && below(2) == 0) {
+                move = pushMoves[below(pushOffCount > 0 ? pushOffCount : static_cast<int>(pushMoves.size()))];
+            }
+
+            const MoveUndo undo = board.makeMove(move);
+            if (marbles(board, opponentOf(toMove)) <= 8) {
+                board.unmakeMove(undo);  // that move would end the game
+                break;
+            }
+            toMove = opponentOf(toMove);
+        }
+        return {board, toMove};
+    }
+};
+
+int main(int argc, char* argv[]) {
+    const long long count = (argc > 1) ? std::atoll(argv[1]) : 1000;
+    const unsigned long long seed = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 1;
+    const std::string outputFileName = (argc > 3) ? argv[3] : "positions.input";
+    PositionGenerator generator{std::mt19937_64(seed), (argc > 4) ? std::atoi(argv[4]) : 120};
+    if (count < 1 || generator.maxPlies < 0) {
+        std::cerr << "usage: posgen [positions >= 1] [seed] [output file] [max plies >= 0]" << std::endl;
+        return 1;
+    }
+
+    std::ofstream outFile(outputFileName);
+    if (!outFile) {
+        std::cerr << "Error: Could not open file " << outputFileName << std::endl;
+        return 1;
+    }
+
+    // marbles on the board across the corpus, to show the spread of game phases
+    std::array<long long, 29> marbleCounts{};
+    for (long long i = 0; i < count; i++) {
+        const auto [board, toMove] = generator.next();
+        outFile << (toMove == CellState::BLACK ? 'b' : 'w') << '\n' << board.boardToString() << '\n';
+        marbleCounts[PositionGenerator::marbles(board, CellState::BLACK) +
+                     PositionGenerator::marbles(board, CellState::WHITE)]++;
+    }
+    if (!outFile.flush()) {
+        std::cerr << "Error: Could not write " << outputFileName << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << count << " positions to " << outputFileName << " (seed " << seed << ")" << std::endl;
+    std::cout << "Marbles on the board:";
+    for (size_t marbles = 0; marbles < marbleCounts.size(); marbles++) {
+        if (marbleCounts[marbles] > 0) {
+            std::cout << " " << marbles << ": " << marbleCounts[marbles];
+        }
+    }
+    std::cout << std::endl;
+    return 0;
+}
@@ -0,0 +1,338 @@
+#ifndef ABALONE_PROTOCOL_H
+#define ABALONE_PROTOCOL_H
+
+#include "engine.h"
+#include "book.h"
+#include "engine_service.h"
+#include "eval_weights.h"
+
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+/*
+ * Headless engine protocol, modelled on UCI: one command per line on stdin, replies on stdout,
+ * so a match manager can keep one engine process per game (trial --protocol).
+ *
+ *   protocol                        -> id name ..., option ... lines, then protocolok
+ *   isready                         -> readyok (once earlier commands, a search too, are done)
+ *   newgame                         forget the transposition table
+ *   position layout <1|2|3> [moves <move>...]         a standard layout, Black to move
+ *   position board <marbles> <b|w> [moves <move>...]  marbles as in input files, "C5b,D5b,..."
+ *   go [depth n] [movetime ms] [nodes n] [infinite]   search the position; without limits to
+ *                                   the Depth option. While it runs, an info line per completed
+ *                                   depth, then bestmove <move> (book moves come at once)
+ *   stop                            end the search now -> bestmove
+ *   setoption name <name> value <value>
+ *   quit
+ *
+ * Commands are carried out in order: a command that comes while a search runs waits for its
+ * bestmove, except stop and quit, which end the search at once. The end of the input waits
+ * too, but ends a go infinite, which nothing else could.
+ *
+ * info lines: info depth <d> score <s> nodes <n> nps <n> time <ms> pv <move>...; the score is
+ * from Black's point of view, like every score of the engine, and the pv is read back from the
+ * transposition table. Problems are reported as "info string <text>" and the command is ignored.
+ */
+
+class EngineProtocol {
+    std::istream& input;
+    std::ostream& output;
+    std::mutex outputMutex;
+
+    SearchParams params;
+    EvalWeights weights = evalWeights();
+    std::string bookFileName;
+    OpeningBook book;
+    bool bookLoaded = false;
+
+    AbaloneBoard board;
+    CellState toMove = CellState::BLACK;
+    GameHistory history;
+
+    // the search runs on engine; watcher streams its progress, enforces the limits and sends bestmove
+    EngineService engine;
+    std::thread watcher;
+    std::atomic<bool> stopRequested{false};
+    bool infinite = false;  // the running search has no limit (go infinite)
+
+    struct Limits {
+        int64_t movetimeMs = 0;  // 0: none
+        uint64_t nodes = 0;      // 0: none
+    };
+
+public:
+    // params and the book file are the starting values of the options
+    EngineProtocol(std::istream& input, std::ostream& output, const SearchParams& searchParams,
+                   const std::string& bookFile)
+        : input(input), output(output), params(searchParams) {
+        params.stats = nullptr;
+        params.history = &history.positions();
+        setBook(bookFile);
+        setLayout(1);
+    }
+
+    ~EngineProtocol() {
+        finishSearch(true);
+    }
+
+    // read commands until quit or the end of the input
+    void run() {
+        for (std::string line; std::getline(input, line);) {
+            std::istringstream words(line);
+            std::string command;
+            if (!(words >> command)) {
+                continue;
+            }
+            if (command == "quit") {
+                finishSearch(true);
+                return;
+            }
+            finishSearch(command == "stop");
+            if (command == "protocol") {
+                identify();
+            } else if (command == "isready") {
+                send("readyok");
+            } else if (command == "newgame") {
+                transpositionTable.clear();
+            } else if (command == "position") {
+                position(words);
+            } else if (command == "go") {
+                go(words);
+            } else if (command == "setoption") {
+                setOption(line);
+            } else if (command != "stop") {
+                send("info string unknown command " + command);
+            }
+        }
+        finishSearch(infinite);
+    }
+
+private:
+    void send(const std::string& line) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        output << line << std::endl;
+    }
+
+    void identify() {
+        send("id name Abalone alpha-beta engine");
+        send("option name Depth type spin default " + std::to_string(params.depth) + " min 1 max 64");
+        send("option name Threads type spin default " + std::to_string(params.threads) + " min 1 max 256");
+        send("option name QuiescenceDepth type spin default " + std::to_string(params.quiescenceDepth) +
+             " min 0 max 16");
+        send("option name Contempt type spin default " + std::to_string(params.contempt) + " min -1000 max 1000");
+        send(std::string("option name NullMove type check default ") + (params.nullMove ? "true" : "false"));
+        send(std::string("option name LateMoveReductions type check default ") +
+             (params.lateMoveReductions ? "true" : "false"));
+        send("option name Book type string default " + (bookFileName.empty() ? "none" : bookFileName));
+        send("option name Weights type string default none");
+        send("option name Eval type string default none");
+        send("protocolok");
+    }
+
+    void setBook(const std::string& filename) {
+        bookFileName = (filename == "none") ? "" : filename;
+        bookLoaded = !bookFileName.empty() && book.open(bookFileName);
+    }
+
+    void setLayout(int layout) {
+        board = AbaloneBoard();
+        for (const auto& [pos, color] : parseBoardFromString(layoutString(layout))) {
+            board.setCellState(pos, color == 'b' ? CellState::BLACK : CellState::WHITE);
+        }
+        toMove = CellState::BLACK;
+        history.reset(board, toMove);
+    }
+
+    // position layout <n> | board <marbles> <b|w>, then optionally moves <move>...
+    void position(std::istringstream& words) {
+        std::string kind;
+        words >> kind;
+        if (kind == "layout") {
+            int layout = 0;
+            if (!(words >> layout) || layout < 1 || layout > 3) {
+                send("info string expected position layout <1|2|3>");
+                return;
+            }
+            setLayout(layout);
+        } else if (kind == "board") {
+            std::string marbles;
+            std::string side;
+            if (!(words >> marbles >> side) || (side != "b" && side != "w")) {
+                send("info string expected position board <marbles> <b|w>");
+                return;
+            }
+            AbaloneBoard newBoard;
+            for (const auto& [pos, color] : parseBoardFromString(marbles)) {
+                if (!AbaloneBoard::isValidPosition(pos) || (color != 'b' && color != 'w')) {
+                    send("info string bad marble " + pos + color);
+                    return;
+                }
+                newBoard.setCellState(pos, color == 'b' ? CellState::BLACK : CellState::WHITE);
+            }
+            if (!hasValidMarbleCounts(newBoard)) {
+                send("info string more than " + std::to_string(MARBLES_PER_SIDE) + " marbles of one colour");
+                return;
+            }
+            board = newBoard;
+            toMove = (side == "b") ? CellState::BLACK : CellState::WHITE;
+            history.reset(board, toMove);
+        } else {
+            send("info string expected position layout or position board");
+            return;
+        }
+
+        std::string word;
+        if (!(words >> word)) {
+            return;
+        }
+        if (word != "moves") {
+            send("info string expected moves, got " + word);
+            return;
+        }
+        MoveList legalMoves;
+        while (words >> word) {
+            board.generateLegalMoves(toMove, legalMoves);
+            if (word.size() >= sizeof(Move) || !legalMoves.contains(Move(word))) {
+                send("info string illegal move " + word + ", the position stops before it");
+                return;
+            }
+            board.makeMove(Move(word));
+            toMove = opponentOf(toMove);
+            history.add(board, toMove);
+        }
+    }
+
+    // setoption name <name> value <value>; the value is the rest of the line
+    void setOption(const std::string& line) {
+        const size_t namePos = line.find(" name ");
+        const size_t valuePos = line.find(" value ");
+        if (namePos == std::string::npos || valuePos == std::string::npos || valuePos < namePos) {
+            send("info string expected setoption name <name> value <value>");
+            return;
+        }
+        const std::string name = line.substr(namePos + 6, valuePos - namePos - 6);
+        const std::string value = line.substr(valuePos + 7);
+        const auto number = [&value](int low, int high) { return std::clamp(std::atoi(value.c_str()), low, high); };
+        if (name == "Depth") {
+            params.depth = number(1, 64);
+        } else if (name == "Threads") {
+            params.threads = number(1, 256);
+        } else if (name == "QuiescenceDepth") {
+            params.quiescenceDepth = number(0, 16);
+        } else if (name == "Contempt") {
+            params.contempt = number(-1000, 1000);
+        } else if (name == "NullMove") {
+            params.nullMove = (value == "true");
+        } else if (name == "LateMoveReductions") {
+            params.lateMoveReductions = (value == "true");
+        } else if (name == "Book") {
+            setBook(value);
+            if (!bookFileName.empty() && !bookLoaded) {
+                send("info string could not load book " + value);
+            }
+        } else if (name == "Weights" || name == "Eval") {
+            EvalWeights newWeights = weights;
+            const bool ok = (value == "none") ||
+                            (name == "Weights" ? readEvalWeights(value, newWeights) : parseEvalWeights(value, newWeights));
+            if (!ok) {
+                send("info string bad " + name + " " + value);
+                return;
+            }
+            weights = newWeights;
+            setEvalWeights(weights);
+            transpositionTable.clear();  // its scores were made with the old weights
+        } else {
+            send("info string unknown option " + name);
+        }
+    }
+
+    void go(std::istringstream& words) {
+        SearchParams searchParams = params;
+        Limits limits;
+        bool depthGiven = false;
+        bool unlimited = false;
+        for (std::string word; words >> word;) {
+            if (word == "depth" && words >> searchParams.depth) {
+                searchParams.depth = std::clamp(searchParams.depth, 1, 64);
+                depthGiven = true;
+            } else if (word == "movetime" && words >> limits.movetimeMs) {
+                unlimited = true;
+            } else if (word == "nodes" && words >> limits.nodes) {
+                unlimited = true;
+            } else if (word == "infinite") {
+                unlimited = true;
+            } else {
+                send("info string bad go argument " + word);
+                return;
+            }
+        }
+        if (unlimited && !depthGiven) {
+            searchParams.depth = 64;  // until stopped by a limit or stop
+        }
+        infinite = unlimited && !depthGiven && limits.movetimeMs <= 0 && limits.nodes == 0;
+
+        MoveList legalMoves;
+        board.generateLegalMoves(toMove, legalMoves);
+        if (legalMoves.empty()) {
+            send("bestmove none");
+            return;
+        }
+        if (bookLoaded) {
+            const std::string bookMove = book.probe(hashBoard(board, toMove));
+            if (!bookMove.empty() && legalMoves.contains(Move(bookMove))) {
+                send("info string book move");
+                send("bestmove " + bookMove);
+                return;
+            }
+        }
+        // an info line for every completed iteration, sent from the search thread
+        const auto start = std::chrono::steady_clock::now();
+        searchParams.onIteration = [this, start](const SearchResult& result) {
+            sendInfo(result.depth, result.score, engine.poll().nodes,
+                     std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+        };
+        stopRequested = false;
+        engine.start(board, toMove, searchParams);
+        watcher = std::thread([this, limits, start, fallback = legalMoves[0].str()]() { watch(limits, start, fallback); });
+    }
+
+    // wait for a running search to send its bestmove; with stop, end it now
+    void finishSearch(bool stop) {
+        if (watcher.joinable()) {
+            if (stop) {
+                stopRequested = true;
+            }
+            watcher.join();
+        }
+    }
+
+    // enforce the limits and stop, then send bestmove
+    void watch(const Limits& limits, std::chrono::steady_clock::time_point start, const std::string& fallback) {
+        while (true) {
+            const SearchProgress progress = engine.poll();
+            const int64_t ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            if (progress.done || stopRequested || (limits.movetimeMs > 0 && ms >= limits.movetimeMs) ||
+                (limits.nodes > 0 && progress.nodes >= limits.nodes)) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const SearchResult result = engine.stop();  // after the last info line
+        send("bestmove " + (result.move.empty() ? fallback : result.move));
+    }
+
+    void sendInfo(int depth, int score, uint64_t nodes, int64_t ms) {
+        std::string line = "info depth " + std::to_string(depth) + " score " + std::to_string(score) + " nodes " +
+                           std::to_string(nodes) + " nps " + std::to_string(nodes * 1000 / std::max<int64_t>(ms, 1)) +
+                           " time " + std::to_string(ms) + " pv";
+        for (const std::string& move : principalVariation(board, toMove, depth)) {
+            line += " " + move;
+        }
+        send(line);
+    }
+};
+
+#endif // ABALONE_PROTOCOL_H
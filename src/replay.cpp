@@ -0,0 +1,90 @@
+#include "engine.h"
+#include "gamerecord.h"
+
+#include <iostream>
+
+/*
+ * Inspect a game record file (see gamerecord.h).
+ *   replay <file>               list the games
+ *   replay <file> <game>        the moves of one game (numbered from 0), with their searches
+ *   replay <file> <game> <ply>  the position before that ply, in the input file format
+ */
+
+const char* resultName(uint8_t result) {
+    switch (static_cast<GameResult>(result)) {
+        case GameResult::BLACK_WINS: return "black wins";
+        case GameResult::WHITE_WINS: return "white wins";
+        case GameResult::DRAW: return "draw";
+        default: return "no result";
+    }
+}
+
+const char* sourceName(uint8_t source) {
+    switch (static_cast<MoveSource>(source)) {
+        case MoveSource::SEARCH: return "search";
+        case MoveSource::BOOK: return "book";
+        case MoveSource::PONDER: return "ponder";
+        case MoveSource::MCTS: return "mcts";
+        default: return "player";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: replay <record file> [game] [ply]" << std::endl;
+        return 1;
+    }
+    GameRecordFile records;
+    if (!records.open(argv[1])) {
+        std::cerr << "Error: Could not read game records from " << argv[1] << std::endl;
+        return 1;
+    }
+
+    if (argc == 2) {
+        for (size_t i = 0; i < records.gameCount(); i++) {
+            const GameHeader& info = records.game(i).info();
+            std::cout << "Game " << i << ": layout " << int(info.layout) << ", " << records.game(i).plyCount()
+                      << " plies, " << resultName(info.result) << " (engine "
+                      << (info.engineSide == 2 ? "both sides" : info.engineSide == 0 ? "black" : "white")
+                      << ", depth " << int(info.depth) << ", quiescence " << int(info.quiescenceDepth)
+                      << ", threads " << int(info.threads) << ")" << std::endl;
+        }
+        return 0;
+    }
+
+    const size_t gameIndex = std::strtoull(argv[2], nullptr, 10);
+    if (gameIndex >= records.gameCount()) {
+        std::cerr << "Error: there are " << records.gameCount() << " games" << std::endl;
+        return 1;
+    }
+    const GameRecord& game = records.game(gameIndex);
+
+    if (argc == 3) {
+        for (uint32_t ply = 0; ply < game.plyCount(); ply++) {
+            std::cout << ply << " " << game.move(ply).view();
+            if (game.hasStats()) {
+                const PlyRecord stats = game.stats(ply);
+                std::cout << " " << sourceName(stats.source);
+                if (stats.source == static_cast<uint8_t>(MoveSource::MCTS)) {
+                    std::cout << " playouts " << stats.nodes << " black " << stats.score / 10.0 << "% "
+                              << stats.timeMs << " ms";
+                } else if (stats.depth > 0) {
+                    std::cout << " depth " << int(stats.depth) << " score " << stats.score << " nodes " << stats.nodes
+                              << " " << stats.timeMs << " ms";
+                }
+            }
+            std::cout << std::endl;
+        }
+        return 0;
+    }
+
+    GameReplay replay(game);
+    if (replay.plyCount() < game.plyCount()) {
+        std::cerr << "Warning: the move at ply " << replay.plyCount() << " is not legal, the game stops before it"
+                  << std::endl;
+    }
+    replay.seek(static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)));
+    std::cout << (replay.sideToMove() == CellState::BLACK ? "b" : "w") << std::endl;
+    std::cout << replay.position().boardToString() << std::endl;
+    return 0;
+}
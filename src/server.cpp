@@ -0,0 +1,697 @@
+#include "engine.h"
+#include "analysis_pool.h"
+#include "eval_weights.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <future>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+/*
+ * Analysis server: engine analysis over HTTP and WebSocket from one long-running process, for
+ * the simpleGUI and other tools. Requests are searched by a fixed pool of workers sharing one
+ * transposition table (see analysis_pool.h), each under its own time limit.
+ *
+ * usage: server [options]
+ *   --port n          (default 8080)
+ *   --bind address    (default 127.0.0.1, this machine only)
+ *   --workers n       searches at a time (default: one per core)
+ *   --queue n         requests that may wait for a worker before new ones are refused (default 256)
+ *   --connections n   connections served at a time; more are refused with status 503 (default 256)
+ *   --time ms         think time of a request without limits (default 1000)
+ *   --max-time ms     upper bound of every request's think time (default 60000)
+ *   --hash n          entries of the transposition table, allocated at start-up (default 1048576)
+ *   --weights <file>, --eval <feature>=<weight>,...   evaluation weights, as for trial
+ *
+ * A request is a set of parameters, in the query string or the body
+ * (application/x-www-form-urlencoded):
+ *   board=C5b,D5b,...   the marbles, as in input files   or   layout=1|2|3
+ *   side=b|w            side to move (default b)
+ *   depth=n, movetime=ms, nodes=n   limits; the search ends at the first one reached
+ *   id=...              (WebSocket) echoed in the replies
+ * The body of a POST may also be an input file: the side to move on the first line, the marbles
+ * on the second.
+ *
+ *   GET|POST /analyze   -> {"bestmove":"iC5NE","score":12,"depth":6,"nodes":..,"nps":..,"time":..,"pv":[..]}
+ *   GET /status         -> workers, busy, queued, completed, tt (positions in the table)
+ *   GET /ws             WebSocket: every text message is a request, answered with an
+ *                       {"type":"info",...} message per completed depth and a final
+ *                       {"type":"result",...}; the message "stop" cancels the connection's requests.
+ *                       Messages over 64 KiB close the connection (status 1009)
+ * An /analyze request is cancelled when its client's connection is reset or hung up; a client
+ * that only closes its sending side still gets its answer. Scores are from Black's point of view.
+ * Errors are {"error":"..."} with status 400, or 503 when the queue is full or there are too many
+ * connections.
+ *
+ * Try it: curl 'http://127.0.0.1:8080/analyze?layout=1&movetime=500'
+ */
+
+struct ServerOptions {
+    int port = 8080;
+    std::string bindAddress = "127.0.0.1";
+    int workers = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    size_t queue = 256;
+    size_t connections = 256;
+    int64_t timeMs = 1000;
+    int64_t maxTimeMs = 60000;
+    size_t hashEntries = size_t{1} << 20;
+};
+
+// ---- encoding helpers ----
+
+// SHA-1, only for the WebSocket handshake
+std::array<uint8_t, 20> sha1(const std::string& message) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::string data = message;
+    data += static_cast<char>(0x80);
+    while (data.size() % 64 != 56) {
+        data += '\0';
+    }
+    const uint64_t bits = static_cast<uint64_t>(message.size()) * 8;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        data += static_cast<char>((bits >> shift) & 0xFF);
+    }
+    const auto rotate = [](uint32_t value, int count) { return (value << count) | (value >> (32 - count)); };
+    for (size_t chunk = 0; chunk < data.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            w[i] = 0;
+            for (int byte = 0; byte < 4; byte++) {
+                w[i] = (w[i] << 8) | static_cast<uint8_t>(data[chunk + 4 * i + byte]);
+            }
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            const uint32_t next = rotate(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotate(b, 30);
+            b = a;
+            a = next;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    std::array<uint8_t, 20> digest{};
+    for (int i = 0; i < 20; i++) {
+        digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - 8 * (i % 4)));
+    }
+    return digest;
+}
+
+std::string base64(const uint8_t* bytes, size_t size) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string text;
+    for (size_t i = 0; i < size; i += 3) {
+        const uint32_t group = (bytes[i] << 16) | ((i + 1 < size ? bytes[i + 1] : 0) << 8) |
+                               (i + 2 < size ? bytes[i + 2] : 0);
+        text += ALPHABET[(group >> 18) & 63];
+        text += ALPHABET[(group >> 12) & 63];
+        text += (i + 1 < size) ? ALPHABET[(group >> 6) & 63] : '=';
+        text += (i + 2 < size) ? ALPHABET[group & 63] : '=';
+    }
+    return text;
+}
+
+std::string urlDecode(const std::string& text) {
+    std::string decoded;
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] == '+') {
+            decoded += ' ';
+        } else if (text[i] == '%' && i + 2 < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+                   std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+            decoded += static_cast<char>(std::stoi(text.substr(i + 1, 2), nullptr, 16));
+            i += 2;
+        } else {
+            decoded += text[i];
+        }
+    }
+    return decoded;
+}
+
+// "a=1&b=2" into params (later values win)
+void parseParams(const std::string& text, std::map<std::string, std::string>& params) {
+    std::istringstream pairs(text);
+    for (std::string pair; std::getline(pairs, pair, '&');) {
+        const size_t equals = pair.find('=');
+        if (!pair.empty()) {
+            params[urlDecode(pair.substr(0, equals))] =
+                (equals == std::string::npos) ? "" : urlDecode(pair.substr(equals + 1));
+        }
+    }
+}
+
+std::string jsonString(const std::string& text) {
+    std::string json = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            json += ' ';
+        } else {
+            json += c;
+        }
+    }
+    return json + "\"";
+}
+
+std::string errorJson(const std::string& message, const std::string& id = "") {
+    return "{" + (id.empty() ? "" : "\"id\":" + jsonString(id) + ",") + "\"type\":\"error\",\"error\":" +
+           jsonString(message) + "}";
+}
+
+// an iteration ("info") or the result of a request as a JSON object
+std::string analysisJson(const AnalysisInfo& info, const char* type, const std::string& id) {
+    std::string json = "{" + (id.empty() ? "" : "\"id\":" + jsonString(id) + ",") + "\"type\":\"" + type +
+                       "\",\"bestmove\":" + (info.move.empty() ? "null" : jsonString(info.move)) +
+                       ",\"score\":" + std::to_string(info.score) + ",\"depth\":" + std::to_string(info.depth) +
+                       ",\"nodes\":" + std::to_string(info.nodes) +
+                       ",\"nps\":" + std::to_string(info.nodes * 1000 / std::max<int64_t>(info.timeMs, 1)) +
+                       ",\"time\":" + std::to_string(info.timeMs) + ",\"pv\":[";
+    for (size_t i = 0; i < info.pv.size(); i++) {
+        json += (i ? "," : "") + jsonString(info.pv[i]);
+    }
+    json += "]";
+    if (std::string(type) == "result") {
+        json += std::string(",\"cancelled\":") + (info.cancelled ? "true" : "false");
+    }
+    return json + "}";
+}
+
+// ---- requests ----
+
+// an analysis request from its parameters; false with an error message if they are invalid
+bool makeRequest(const std::map<std::string, std::string>& params, const ServerOptions& options,
+                 AnalysisRequest& request, std::string& error) {
+    const auto param = [&params](const std::string& name) {
+        const auto it = params.find(name);
+        return (it == params.end()) ? std::string() : it->second;
+    };
+    const auto number = [&param](const std::string& name, int64_t& value) {
+        const std::string text = param(name);
+        if (text.empty()) {
+            return false;
+        }
+        char* end = nullptr;
+        value = std::strtoll(text.c_str(), &end, 10);
+        return *end == '\0' && value > 0;
+    };
+
+    const std::string layout = param("layout");
+    std::string marbles = param("board");
+    if (!layout.empty()) {
+        if (layout != "1" && layout != "2" && layout != "3") {
+            error = "layout must be 1, 2 or 3";
+            return false;
+        }
+        marbles = layoutString(std::stoi(layout));
+    } else if (marbles.empty()) {
+        error = "missing board (or layout)";
+        return false;
+    }
+    request.board = AbaloneBoard();
+    for (const auto& [pos, color] : parseBoardFromString(marbles)) {
+        if (!AbaloneBoard::isValidPosition(pos) || (color != 'b' && color != 'w')) {
+            error = "bad marble " + pos + color;
+            return false;
+        }
+        request.board.setCellState(pos, color == 'b' ? CellState::BLACK : CellState::WHITE);
+    }
+    if (!hasValidMarbleCounts(request.board)) {
+        error = "more than " + std::to_string(MARBLES_PER_SIDE) + " marbles of one colour";
+        return false;
+    }
+    const std::string side = param("side");
+    if (!side.empty() && side != "b" && side != "w") {
+        error = "side must be b or w";
+        return false;
+    }
+    request.toMove = (side == "w") ? CellState::WHITE : CellState::BLACK;
+
+    int64_t depth = 0;
+    int64_t movetime = 0;
+    int64_t nodes = 0;
+    for (const auto& [name, value] : {std::pair<const char*, int64_t*>{"depth", &depth},
+                                      {"movetime", &movetime}, {"nodes", &nodes}}) {
+        if (!param(name).empty() && !number(name, *value)) {
+            error = std::string(name) + " must be a positive number";
+            return false;
+        }
+    }
+    request.depth = (depth > 0) ? static_cast<int>(std::min<int64_t>(depth, 64)) : 64;
+    request.nodes = static_cast<uint64_t>(nodes);
+    // every request has a time limit: its own, the default one if it has no limits at all, or the maximum
+    request.movetimeMs = (movetime > 0)             ? std::min(movetime, options.maxTimeMs)
+                         : (depth > 0 || nodes > 0) ? options.maxTimeMs
+                                                    : std::min(options.timeMs, options.maxTimeMs);
+    return true;
+}
+
+// the id of a WebSocket request, kept short and plain
+std::string requestId(const std::map<std::string, std::string>& params) {
+    const auto it = params.find("id");
+    std::string id;
+    if (it != params.end()) {
+        for (const char c : it->second.substr(0, 64)) {
+            id += (std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_') ? c : '_';
+        }
+    }
+    return id;
+}
+
+// ---- connections ----
+
+// largest request body, and largest WebSocket message (also when sent in fragments)
+const size_t MAX_MESSAGE_SIZE = 65536;
+
+class Connection {
+    int socket;
+    std::string buffer;  // received, not yet consumed
+    std::mutex sendMutex;
+    std::atomic<bool> open{true};
+
+public:
+    explicit Connection(int socket) : socket(socket) {}
+
+    ~Connection() {
+        ::close(socket);
+    }
+
+    // send all of data; false once the peer is gone
+    bool send(const std::string& data) {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        for (size_t sent = 0; open && sent < data.size();) {
+            const ssize_t count = ::send(socket, data.data() + sent, data.size() - sent, 0);
+            if (count <= 0) {
+                open = false;
+                break;
+            }
+            sent += static_cast<size_t>(count);
+        }
+        return open;
+    }
+
+    // no more sends or reads; the socket itself is closed with the last reference (a search may
+    // still be about to report to it)
+    void shutdown() {
+        open = false;
+        ::shutdown(socket, SHUT_RDWR);
+    }
+
+    // read until buffer holds at least size bytes; false at the end of the stream or on a timeout
+    bool fill(size_t size) {
+        char chunk[4096];
+        while (buffer.size() < size) {
+            const ssize_t count = ::recv(socket, chunk, sizeof(chunk), 0);
+            if (count <= 0) {
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(count));
+        }
+        return true;
+    }
+
+    // the text up to delimiter, which is consumed; gives up after maxSize bytes
+    bool readUntil(const std::string& delimiter, size_t maxSize, std::string& text) {
+        size_t found;
+        while ((found = buffer.find(delimiter)) == std::string::npos) {
+            if (buffer.size() > maxSize || !fill(buffer.size() + 1)) {
+                return false;
+            }
+        }
+        text = buffer.substr(0, found);
+        buffer.erase(0, found + delimiter.size());
+        return true;
+    }
+
+    bool read(size_t size, std::string& data) {
+        if (!fill(size)) {
+            return false;
+        }
+        data = buffer.substr(0, size);
+        buffer.erase(0, size);
+        return true;
+    }
+
+    // has the connection been reset or hung up? Doesn't wait. The end of the stream doesn't count:
+    // a client may shut down only its sending side (curl --data does) and still read the reply
+    bool peerClosed() {
+        pollfd events{socket, 0, 0};
+        return ::poll(&events, 1, 0) > 0 && (events.revents & (POLLERR | POLLHUP));
+    }
+
+    void setReadTimeout(int seconds) {
+        timeval timeout{seconds, 0};
+        setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+};
+
+struct HttpRequest {
+    std::string method;
+    std::string path;
+    std::string query;
+    std::map<std::string, std::string> headers;  // names in lower case
+    std::string body;
+
+    [[nodiscard]] std::string header(const std::string& name) const {
+        const auto it = headers.find(name);
+        return (it == headers.end()) ? std::string() : it->second;
+    }
+};
+
+bool readHttpRequest(Connection& connection, HttpRequest& request) {
+    std::string head;
+    if (!connection.readUntil("\r\n\r\n", 16384, head)) {
+        return false;
+    }
+    std::istringstream lines(head);
+    std::string line;
+    std::getline(lines, line);
+    std::istringstream requestLine(line);
+    std::string target;
+    requestLine >> request.method >> target;
+    const size_t question = target.find('?');
+    request.path = target.substr(0, question);
+    request.query = (question == std::string::npos) ? "" : target.substr(question + 1);
+    while (std::getline(lines, line)) {
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+        std::string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(' '));
+        value.erase(value.find_last_not_of(" \r") + 1);
+        request.headers[name] = value;
+    }
+    const size_t length = std::strtoull(request.header("content-length").c_str(), nullptr, 10);
+    return length <= MAX_MESSAGE_SIZE && (length == 0 || connection.read(length, request.body));
+}
+
+void sendHttp(Connection& connection, int status, const std::string& body, bool keepAlive,
+              const std::string& contentType = "application/json") {
+    static const std::map<int, std::string> REASONS = {{200, "OK"}, {204, "No Content"}, {400, "Bad Request"},
+                                                       {404, "Not Found"}, {503, "Service Unavailable"}};
+    connection.send("HTTP/1.1 " + std::to_string(status) + " " + REASONS.at(status) +
+                    "\r\nContent-Type: " + contentType + "\r\nContent-Length: " + std::to_string(body.size()) +
+                    "\r\nAccess-Control-Allow-Origin: *\r\nAccess-Control-Allow-Methods: GET, POST, OPTIONS"
+                    "\r\nAccess-Control-Allow-Headers: Content-Type\r\nConnection: " +
+                    (keepAlive ? "keep-alive" : "close") + "\r\n\r\n" + body);
+}
+
+// ---- WebSocket (RFC 6455) ----
+
+void sendFrame(Connection& connection, int opcode, const std::string& payload) {
+    std::string frame(1, static_cast<char>(0x80 | opcode));
+    if (payload.size() < 126) {
+        frame += static_cast<char>(payload.size());
+    } else if (payload.size() < 65536) {
+        frame += static_cast<char>(126);
+        frame += static_cast<char>(payload.size() >> 8);
+        frame += static_cast<char>(payload.size() & 0xFF);
+    } else {
+        frame += static_cast<char>(127);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            frame += static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xFF);
+        }
+    }
+    connection.send(frame + payload);
+}
+
+// read one frame; false when the connection is gone or breaks the protocol
+bool readFrame(Connection& connection, bool& final, int& opcode, std::string& payload) {
+    std::string header;
+    if (!connection.read(2, header)) {
+        return false;
+    }
+    final = (header[0] & 0x80) != 0;
+    opcode = header[0] & 0x0F;
+    const bool masked = (header[1] & 0x80) != 0;
+    uint64_t length = header[1] & 0x7F;
+    if (length >= 126) {
+        std::string extended;
+        if (!connection.read(length == 126 ? 2 : 8, extended)) {
+            return false;
+        }
+        length = 0;
+        for (const char byte : extended) {
+            length = (length << 8) | static_cast<uint8_t>(byte);
+        }
+    }
+    std::string mask;
+    if (!masked || length > MAX_MESSAGE_SIZE || !connection.read(4, mask) || !connection.read(length, payload)) {
+        return false;  // clients must mask their frames
+    }
+    for (size_t i = 0; i < payload.size(); i++) {
+        payload[i] = static_cast<char>(payload[i] ^ mask[i % 4]);
+    }
+    return true;
+}
+
+void serveWebSocket(const std::shared_ptr<Connection>& connection, const HttpRequest& handshake,
+                    AnalysisPool& pool, const ServerOptions& options) {
+    static const std::string GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    const std::array<uint8_t, 20> digest = sha1(handshake.header("sec-websocket-key") + GUID);
+    connection->send("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: " + base64(digest.data(), digest.size()) + "\r\n\r\n");
+    connection->setReadTimeout(0);  // a client may watch for a long time between requests
+
+    std::vector<AnalysisPool::CancelFlag> requests;  // of this connection, to cancel on stop and close
+    std::string message;
+    bool final = false;
+    int opcode = 0;
+    std::string payload;
+    while (readFrame(*connection, final, opcode, payload)) {
+        if (opcode == 0x8) {  // close
+            sendFrame(*connection, 0x8, payload.substr(0, 2));
+            break;
+        } else if (opcode == 0x9) {  // ping
+            sendFrame(*connection, 0xA, payload);
+            continue;
+        } else if (opcode == 0xA) {  // pong
+            continue;
+        }
+        if (message.size() + payload.size() > MAX_MESSAGE_SIZE) {
+            sendFrame(*connection, 0x8, "\x03\xF1");  // status 1009: message too big
+            break;
+        }
+        message += payload;
+        if (!final) {
+            continue;
+        }
+        const std::string text = std::move(message);
+        message.clear();
+        if (text == "stop") {
+            for (const auto& cancelled : requests) {
+                *cancelled = true;
+            }
+            requests.clear();
+            continue;
+        }
+
+        std::map<std::string, std::string> params;
+        parseParams(text, params);
+        const std::string id = requestId(params);
+        AnalysisRequest request;
+        std::string error;
+        if (!makeRequest(params, options, request, error)) {
+            sendFrame(*connection, 0x1, errorJson(error, id));
+            continue;
+        }
+        auto cancelled = std::make_shared<std::atomic<bool>>(false);
+        const bool queued = pool.submit(
+            request,
+            [connection, id](const AnalysisInfo& info) { sendFrame(*connection, 0x1, analysisJson(info, "info", id)); },
+            [connection, id](const AnalysisInfo& info) { sendFrame(*connection, 0x1, analysisJson(info, "result", id)); },
+            cancelled);
+        if (!queued) {
+            sendFrame(*connection, 0x1, errorJson("queue full", id));
+            continue;
+        }
+        // forget finished requests now and then
+        if (requests.size() >= 64) {
+            requests.erase(std::remove_if(requests.begin(), requests.end(),
+                                          [](const auto& flag) { return flag.use_count() == 1; }),
+                           requests.end());
+        }
+        requests.push_back(cancelled);
+    }
+    for (const auto& cancelled : requests) {
+        *cancelled = true;
+    }
+}
+
+void serveConnection(const std::shared_ptr<Connection>& connection, AnalysisPool& pool, const ServerOptions& options) {
+    connection->setReadTimeout(60);  // idle keep-alive connections are closed
+    HttpRequest request;
+    while (readHttpRequest(*connection, request)) {
+        const bool keepAlive = request.header("connection") != "close";
+        if (request.method == "OPTIONS") {  // CORS preflight
+            sendHttp(*connection, 204, "", keepAlive);
+        } else if (request.path == "/ws" && request.header("upgrade") == "websocket") {
+            serveWebSocket(connection, request, pool, options);
+            break;
+        } else if (request.path == "/analyze" && (request.method == "GET" || request.method == "POST")) {
+            std::map<std::string, std::string> params;
+            parseParams(request.query, params);
+            if (request.body.find('=') != std::string::npos) {
+                parseParams(request.body, params);
+            } else if (!request.body.empty()) {  // an input file: the side to move, then the marbles
+                std::istringstream lines(request.body);
+                std::string line;
+                std::getline(lines, line);
+                params["side"] = line.substr(0, 1);
+                std::getline(lines, line);
+                params["board"] = line.substr(0, line.find_last_not_of("\r\n ") + 1);
+            }
+            AnalysisRequest analysis;
+            std::string error;
+            if (!makeRequest(params, options, analysis, error)) {
+                sendHttp(*connection, 400, errorJson(error), keepAlive);
+            } else {
+                auto result = std::make_shared<std::promise<AnalysisInfo>>();
+                std::future<AnalysisInfo> done = result->get_future();
+                auto cancelled = std::make_shared<std::atomic<bool>>(false);
+                if (!pool.submit(analysis, nullptr, [result](const AnalysisInfo& info) { result->set_value(info); },
+                                 cancelled)) {
+                    sendHttp(*connection, 503, errorJson("queue full"), keepAlive);
+                } else {
+                    // a client whose connection is gone no longer wants the answer: free its worker
+                    while (done.wait_for(std::chrono::milliseconds(20)) != std::future_status::ready) {
+                        if (!*cancelled && connection->peerClosed()) {
+                            *cancelled = true;
+                        }
+                    }
+                    sendHttp(*connection, 200, analysisJson(done.get(), "result", ""), keepAlive);
+                }
+            }
+        } else if (request.path == "/status" && request.method == "GET") {
+            const AnalysisPool::Status status = pool.status();
+            sendHttp(*connection, 200,
+                     "{\"workers\":" + std::to_string(status.workers) + ",\"busy\":" + std::to_string(status.busy) +
+                         ",\"queued\":" + std::to_string(status.queued) +
+                         ",\"completed\":" + std::to_string(status.completed) +
+                         ",\"tt\":" + std::to_string(transpositionTable.size()) + "}",
+                     keepAlive);
+        } else if (request.path == "/" && request.method == "GET") {
+            sendHttp(*connection, 200,
+                     "Abalone analysis server\n"
+                     "GET|POST /analyze?board=C5b,D5b,...&side=b&movetime=1000 (or layout=1..3; depth, nodes)\n"
+                     "GET /status\nGET /ws (WebSocket: one request per text message, \"stop\" to cancel)\n",
+                     keepAlive, "text/plain");
+        } else {
+            sendHttp(*connection, 404, errorJson("unknown path " + request.path), keepAlive);
+        }
+        if (!keepAlive) {
+            break;
+        }
+        request = HttpRequest();
+    }
+    connection->shutdown();
+}
+
+int main(int argc, char* argv[]) {
+    ServerOptions options;
+    SearchParams searchParams;
+    EvalWeights weights = evalWeights();
+    for (int arg = 1; arg < argc; arg++) {
+        const std::string option = argv[arg];
+        if (option == "--port" && arg + 1 < argc) {
+            options.port = std::atoi(argv[++arg]);
+        } else if (option == "--bind" && arg + 1 < argc) {
+            options.bindAddress = argv[++arg];
+        } else if (option == "--workers" && arg + 1 < argc) {
+            options.workers = std::max(1, std::atoi(argv[++arg]));
+        } else if (option == "--queue" && arg + 1 < argc) {
+            options.queue = std::max<size_t>(1, std::strtoull(argv[++arg], nullptr, 10));
+        } else if (option == "--connections" && arg + 1 < argc) {
+            options.connections = std::max<size_t>(1, std::strtoull(argv[++arg], nullptr, 10));
+        } else if (option == "--time" && arg + 1 < argc) {
+            options.timeMs = std::max<int64_t>(1, std::atoll(argv[++arg]));
+        } else if (option == "--max-time" && arg + 1 < argc) {
+            options.maxTimeMs = std::max<int64_t>(1, std::atoll(argv[++arg]));
+        } else if (option == "--hash" && arg + 1 < argc) {
+            options.hashEntries = std::strtoull(argv[++arg], nullptr, 10);
+        } else if (option == "--weights" && arg + 1 < argc) {
+            if (!readEvalWeights(argv[++arg], weights)) {
+                return 1;
+            }
+        } else if (option == "--eval" && arg + 1 < argc) {
+            if (!parseEvalWeights(argv[++arg], weights)) {
+                return 1;
+            }
+        } else {
+            std::cerr << "usage: server [--port n] [--bind address] [--workers n] [--queue n] [--connections n] "
+                         "[--time ms] [--max-time ms] [--hash n] [--weights <file>] [--eval <weights>]" << std::endl;
+            return 1;
+        }
+    }
+    setEvalWeights(weights);
+    std::signal(SIGPIPE, SIG_IGN);  // a client that hangs up is noticed by send instead
+
+    const int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    const int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    if (listener < 0 || inet_pton(AF_INET, options.bindAddress.c_str(), &address.sin_addr) != 1 ||
+        bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        std::cerr << "Error: Could not listen on " << options.bindAddress << ":" << options.port << std::endl;
+        return 1;
+    }
+
+    transpositionTable.resize(options.hashEntries);  // before any search runs
+    AnalysisPool pool(options.workers, options.queue, searchParams);
+    std::cout << "Listening on http://" << options.bindAddress << ":" << options.port << " with " << options.workers
+              << " search workers" << std::endl;
+    std::atomic<size_t> openConnections{0};
+    while (true) {
+        const int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        auto connection = std::make_shared<Connection>(client);
+        if (openConnections >= options.connections) {
+            sendHttp(*connection, 503, errorJson("too many connections"), false);
+            connection->shutdown();
+            continue;
+        }
+        // a thread per connection, up to options.connections; they only parse and wait, the
+        // searching is done by the pool. Only this thread adds to openConnections.
+        openConnections++;
+        std::thread([connection, &pool, &options, &openConnections]() {
+            serveConnection(connection, pool, options);
+            openConnections--;
+        }).detach();
+    }
+}
@@ -0,0 +1,164 @@
+// Runs the Abalone engine (trialgui.js/wasm) off the main thread so the page stays
+// responsive while the AI searches. The engine module only knows positions and moves;
+// the game itself (turns, undo history, results) is kept here.
+//
+// Messages out, besides the replies: {type: 'ready', legacy} once the module has loaded (legacy:
+// see below), or {type: 'error', message} if it failed to.
+//
+// Messages in:
+//   {type: 'call', id, fn, args}            call a game function, reply {type: 'result', id, value}
+//   {type: 'search', id, maxDepth, timeLimitMs}
+//                                           search with progress, reply with 'progress' messages
+//                                           then {type: 'result', id, value: "move:result"}
+//   {type: 'stop'}                          end the current search now (after the running
+//                                           iteration if the module has no threads)
+//
+// A module built before this C ABI (it exports startGame/makeAIMove instead, and keeps the game
+// itself) is driven through those exports: same messages, but no progress and no stopping. The
+// checked-in trialgui.js/trialgui.wasm are such a module until they are rebuilt with emcmake.
+importScripts('trialgui.js');
+
+let engine = null;
+let legacy = null;
+let stopRequested = false;
+
+AbaloneModule().then(Module => {
+  if (!Module._abalone_layout) {
+    legacy = {
+      startGame: Module.cwrap('startGame', null, ['number', 'number']),
+      getBoardState: Module.cwrap('getBoardState', 'string', []),
+      applyManualMove: Module.cwrap('applyManualMove', 'number', ['string']),
+      undoLastMove: Module.cwrap('undoLastMove', 'number', []),
+      makeAIMove: Module.cwrap('makeAIMove', 'string', [])  // "move:result"
+    };
+    postMessage({type: 'ready', legacy: true});
+    return;
+  }
+  engine = {
+    Module,
+    layout: Module.cwrap('abalone_layout', 'string', ['number']),
+    setBoard: Module.cwrap('abalone_set_board', null, ['string', 'number']),
+    getBoard: Module.cwrap('abalone_get_board', 'string', []),
+    legalMoves: Module.cwrap('abalone_legal_moves', 'string', []),
+    playMove: Module.cwrap('abalone_play_move', 'string', ['string']),
+    clearHash: Module.cwrap('abalone_clear_hash', null, []),
+    loadBook: Module.cwrap('abalone_load_book', 'number', ['number', 'number']),
+    searchBegin: Module.cwrap('abalone_search_begin', null, []),
+    searchNext: Module.cwrap('abalone_search_next', 'string', ['number']),
+    searchStart: Module.cwrap('abalone_search_start', 'number', ['number']),
+    searchPoll: Module.cwrap('abalone_search_poll', 'string', []),
+    searchStop: Module.cwrap('abalone_search_stop', null, []),
+    bestMove: Module.cwrap('abalone_best_move', 'string', [])
+  };
+  postMessage({type: 'ready', legacy: false});
+}).catch(err => postMessage({type: 'error', message: String(err)}));
+
+// game state: the position, whose turn it is (0 = black, 1 = white) and earlier positions for undo
+const game = {board: '', toMove: 0, history: []};
+
+// 0 = game continues, 1 = white wins, 2 = black wins
+function gameResult() {
+  const count = color => game.board.split(',').filter(cell => cell.endsWith(color)).length;
+  if (count('b') < 9) return 1;
+  if (count('w') < 9) return 2;
+  return 0;
+}
+
+function playMove(move) {
+  game.history.push({board: game.board, toMove: game.toMove});
+  game.board = engine.playMove(move);
+  game.toMove = 1 - game.toMove;
+  return gameResult();
+}
+
+const gameFunctions = {
+  // aiColor is kept by the page; layout: 1 = Default, 2 = German, 3 = Belgian
+  startGame(aiColor, layout) {
+    game.board = engine.layout(layout);
+    game.toMove = 0;
+    game.history = [];
+    engine.setBoard(game.board, game.toMove);
+    engine.clearHash();
+  },
+
+  getBoardState() {
+    return game.board;
+  },
+
+  // returns -1 for an illegal move, otherwise the game result after the move
+  applyManualMove(move) {
+    if (!engine.legalMoves().split(',').includes(move)) return -1;
+    return playMove(move);
+  },
+
+  // returns -1 if there is nothing to undo
+  undoLastMove() {
+    if (game.history.length === 0) return -1;
+    ({board: game.board, toMove: game.toMove} = game.history.pop());
+    engine.setBoard(game.board, game.toMove);
+    return 0;
+  }
+};
+
+// The opening book is fetched on the first AI move rather than at startup, so the page
+// loads without it; a missing book only means the engine searches every position.
+let bookRequest = null;
+
+function loadBook() {
+  if (!bookRequest) {
+    bookRequest = fetch('opening.book')
+      .then(response => response.ok ? response.arrayBuffer() : null)
+      .then(buffer => {
+        if (!buffer) return;
+        // the engine reads the book in place, so the copy is never freed
+        const bytes = new Uint8Array(buffer);
+        const address = engine.Module._malloc(bytes.length);
+        engine.Module.HEAPU8.set(bytes, address);
+        if (engine.loadBook(address, bytes.length) === 0) engine.Module._free(address);
+      })
+      .catch(() => {});
+  }
+  return bookRequest;
+}
+
+onmessage = event => {
+  const msg = event.data;
+  if (msg.type === 'call') {
+    const functions = legacy || gameFunctions;
+    postMessage({type: 'result', id: msg.id, value: functions[msg.fn](...msg.args)});
+  } else if (msg.type === 'search' && legacy) {
+    postMessage({type: 'result', id: msg.id, value: legacy.makeAIMove()});
+  } else if (msg.type === 'search') {
+    runSearch(msg.id, msg.maxDepth, msg.timeLimitMs);
+  } else if (msg.type === 'stop') {
+    stopRequested = true;
+  }
+};
+
+async function runSearch(id, maxDepth, timeLimitMs) {
+  stopRequested = false;
+  const startTime = performance.now();
+  await loadBook();
+  engine.searchBegin();
+  const report = status => {
+    const [depth, bestMove, score, nodes, done] = status.split(':');
+    postMessage({type: 'progress', id, depth: Number(depth), bestMove, score: Number(score), nodes: Number(nodes)});
+    return done === '1';
+  };
+  if (engine.searchStart(maxDepth)) {
+    // the search runs on a thread of its own and stops at once, as EngineService does natively
+    while (!report(engine.searchPoll())) {
+      await new Promise(resolve => setTimeout(resolve, 20));
+      if (stopRequested || performance.now() - startTime > timeLimitMs) engine.searchStop();
+    }
+  } else {
+    while (!report(engine.searchNext(maxDepth))) {
+      // yield so a 'stop' message can be handled between iterations
+      await new Promise(resolve => setTimeout(resolve, 0));
+      if (stopRequested || performance.now() - startTime > timeLimitMs) break;
+    }
+  }
+  // play the best move found so far; "none:0" if there is no move
+  const move = engine.bestMove();
+  postMessage({type: 'result', id, value: move ? move + ':' + playMove(move) : 'none:0'});
+}
@@ -0,0 +1,240 @@
+#include "../engine.h"
+#include "../book.h"
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define ABALONE_SEARCH_THREAD 1
+#include "../engine_service.h"
+#endif
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#else
+#include <cstdio>
+#define EMSCRIPTEN_KEEPALIVE
+#endif
+
+/*
+ * Browser entry point for simpleGUI: a minimal C ABI over the engine with no iostream or
+ * filesystem dependencies. engine.worker.js loads this module in a Web Worker and keeps the
+ * game state (whose turn it is, undo history, results) on the JavaScript side.
+ *
+ * The search starts with abalone_search_begin. Where the module has threads (and natively) it
+ * then runs in the background like EngineService: abalone_search_start, abalone_search_poll for
+ * progress, abalone_search_stop to stop it at once (the search checks the stop flag at every
+ * node). A single-threaded module can't search while the worker waits for messages, so there
+ * abalone_search_start returns 0 and the worker runs abalone_search_next an iteration at a
+ * time, stopping between iterations. Either way abalone_best_move gives the move.
+ */
+
+namespace {
+
+AbaloneBoard board;
+CellState toMove = CellState::BLACK;
+
+SearchParams searchParams;
+std::atomic<uint64_t> searchNodes{0};
+SearchResult searchBest;  // last completed iteration (or the book move)
+int searchDepth = 0;      // depth of the next iteration
+bool searchDone = true;
+
+OpeningBook book;
+
+#ifdef ABALONE_SEARCH_THREAD
+EngineService engine;  // background search of abalone_search_start
+#endif
+
+std::string returnBuffer;  // backing storage for strings returned to JavaScript
+
+const char* returnString(std::string value) {
+    returnBuffer = std::move(value);
+    return returnBuffer.c_str();
+}
+
+// "depth:bestMove:score:nodes:done" of the current search
+const char* searchStatus() {
+    return returnString(std::to_string(searchBest.depth) + ":" + (searchBest.move.empty() ? "none" : searchBest.move) +
+                        ":" + std::to_string(searchBest.score) + ":" + std::to_string(searchNodes.load()) + ":" +
+                        (searchDone ? "1" : "0"));
+}
+
+// end the search, keeping the best move found so far
+void stopSearch() {
+#ifdef ABALONE_SEARCH_THREAD
+    if (engine.isRunning()) {
+        const SearchResult result = engine.stop();
+        if (!result.move.empty()) {
+            searchBest = result;
+        }
+    }
+#endif
+    searchDone = true;
+}
+
+} // namespace
+
+extern "C" {
+
+// starting position for a layout (1 = Default, 2 = German, 3 = Belgian)
+EMSCRIPTEN_KEEPALIVE const char* abalone_layout(int layout) {
+    return returnString(layoutString(layout));
+}
+
+// set the position to search; toMoveColor: 0 = black, 1 = white. A board with more than 14
+// marbles of a colour is replaced by an empty one.
+EMSCRIPTEN_KEEPALIVE void abalone_set_board(const char* boardString, int toMoveColor) {
+    stopSearch();
+    board = AbaloneBoard();
+    for (const auto& [pos, color] : parseBoardFromString(boardString)) {
+        board.setCellState(pos, color == 'b' ? CellState::BLACK : CellState::WHITE);
+    }
+    if (!hasValidMarbleCounts(board)) {
+        board = AbaloneBoard();
+    }
+    toMove = (toMoveColor == 0) ? CellState::BLACK : CellState::WHITE;
+    searchDone = true;
+}
+
+EMSCRIPTEN_KEEPALIVE const char* abalone_get_board() {
+    return returnString(board.boardToString());
+}
+
+// comma-separated legal moves for the side to move
+EMSCRIPTEN_KEEPALIVE const char* abalone_legal_moves() {
+    std::string moves;
+    for (const std::string& move : board.generateLegalMoves(toMove)) {
+        moves += move;
+        moves += ',';
+    }
+    if (!moves.empty()) moves.pop_back();
+    return returnString(std::move(moves));
+}
+
+// play a move (legality is the caller's business, see abalone_legal_moves) and hand the turn
+// to the other side; returns the new board
+EMSCRIPTEN_KEEPALIVE const char* abalone_play_move(const char* move) {
+    stopSearch();
+    board = boardAfterMove(board, move);
+    toMove = (toMove == CellState::BLACK) ? CellState::WHITE : CellState::BLACK;
+    return abalone_get_board();
+}
+
+// forget everything learned in earlier searches (new game)
+EMSCRIPTEN_KEEPALIVE void abalone_clear_hash() {
+    transpositionTable.clear();
+}
+
+// use an opening book that JavaScript downloaded into module memory; the bytes must stay
+// allocated. Returns the number of book positions, 0 if the data is not a valid book.
+EMSCRIPTEN_KEEPALIVE int abalone_load_book(const char* data, int length) {
+    return book.attach(data, static_cast<size_t>(length)) ? static_cast<int>(book.size()) : 0;
+}
+
+EMSCRIPTEN_KEEPALIVE void abalone_search_begin() {
+    stopSearch();
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+    // one search thread per core (each one is a Web Worker in the threaded WebAssembly build)
+    searchParams.threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+#endif
+    searchNodes = 0;
+    searchParams.nodes = &searchNodes;
+    searchBest = SearchResult();
+    searchDepth = 1;
+
+    const std::vector<std::string> legalMoves = board.generateLegalMoves(toMove);
+    searchDone = legalMoves.empty();
+
+    // book positions need no search
+    const std::string bookMove = book.probe(hashBoard(board, toMove));
+    if (std::find(legalMoves.begin(), legalMoves.end(), bookMove) != legalMoves.end()) {
+        searchBest.move = bookMove;
+        searchDone = true;
+    }
+}
+
+// run the next iteration, up to maxDepth; returns "depth:bestMove:score:nodes:done"
+EMSCRIPTEN_KEEPALIVE const char* abalone_search_next(int maxDepth) {
+    if (!searchDone && searchDepth <= maxDepth) {
+        auto [score, move] = searchRoot(board, toMove, searchDepth, searchParams);
+        if (!move.empty()) {
+            searchBest = {score, move, searchDepth};
+        }
+        searchDepth++;
+    }
+    searchDone = searchDone || searchDepth > maxDepth;
+    return searchStatus();
+}
+
+// search up to maxDepth in the background; returns 0 if this module has no threads, then
+// the caller runs the iterations itself with abalone_search_next
+EMSCRIPTEN_KEEPALIVE int abalone_search_start(int maxDepth) {
+#ifdef ABALONE_SEARCH_THREAD
+    if (!searchDone) {
+        SearchParams params = searchParams;
+        params.depth = maxDepth;
+        engine.start(board, toMove, params);
+    }
+    return 1;
+#else
+    (void)maxDepth;
+    return 0;
+#endif
+}
+
+// progress of the background search, in the form of abalone_search_next
+EMSCRIPTEN_KEEPALIVE const char* abalone_search_poll() {
+#ifdef ABALONE_SEARCH_THREAD
+    if (engine.isRunning()) {
+        const SearchProgress progress = engine.poll();
+        searchNodes = progress.nodes;
+        if (progress.depth > 0) {
+            searchBest = {progress.score, progress.bestMove, progress.depth};
+        }
+        if (progress.done) {
+            stopSearch();
+        }
+    }
+#endif
+    return searchStatus();
+}
+
+// stop the background search now; the best move so far stays in abalone_best_move
+EMSCRIPTEN_KEEPALIVE void abalone_search_stop() {
+    stopSearch();
+}
+
+// best move found so far by the current search, "" if there is none
+EMSCRIPTEN_KEEPALIVE const char* abalone_best_move() {
+    return returnString(searchBest.move);
+}
+
+} // extern "C"
+
+#ifndef __EMSCRIPTEN__
+// native smoke test: the engine plays itself for a few moves, searching alternately in steps
+// (as without threads) and in the background, stopped after 200 ms as the worker would
+int main() {
+    abalone_set_board(abalone_layout(1), 0);
+    for (int i = 0; i < 6; i++) {
+        abalone_search_begin();
+        std::string progress;  // copied, the next call reuses the return buffer
+        if (i % 2 == 0) {
+            while (!searchDone) {
+                progress = abalone_search_next(SearchParams().depth);
+            }
+        } else {
+            abalone_search_start(64);
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+            while (!searchDone && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                abalone_search_poll();
+            }
+            abalone_search_stop();
+            progress = abalone_search_poll();
+        }
+        std::printf("%s\n", progress.c_str());
+        abalone_play_move(searchBest.move.c_str());
+    }
+    std::printf("%s\n", abalone_get_board());
+    return 0;
+}
+#endif
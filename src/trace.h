@@ -0,0 +1,150 @@
+#ifndef ABALONE_TRACE_H
+#define ABALONE_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Scoped trace points for the engine's hot paths. TRACE_SCOPE("name") records the time spent in
+ * the enclosing block into a ring buffer owned by the current thread; writeChromeTrace dumps all
+ * buffers as Chrome trace-event JSON (chrome://tracing, or ui.perfetto.dev).
+ *
+ * Trace points are only compiled in when ABALONE_TRACE is defined (cmake -DABALONE_TRACE=ON);
+ * otherwise TRACE_SCOPE expands to nothing and costs nothing.
+ */
+
+#ifdef ABALONE_TRACE
+const bool TRACE_ENABLED = true;
+#define ABALONE_TRACE_CONCAT_(a, b) a##b
+#define ABALONE_TRACE_CONCAT(a, b) ABALONE_TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope ABALONE_TRACE_CONCAT(traceScope, __LINE__)(name)
+#else
+const bool TRACE_ENABLED = false;
+#define TRACE_SCOPE(name) ((void)0)
+#endif
+
+// one completed scope; name must be a string literal
+struct TraceEvent {
+    const char* name;
+    uint64_t start;     // nanoseconds since the first trace point
+    uint64_t duration;  // nanoseconds
+};
+
+// Events of one thread. When full, the oldest events are overwritten.
+struct TraceBuffer {
+    static const size_t CAPACITY = size_t{1} << 16;
+
+    int id = 0;
+    std::vector<TraceEvent> events = std::vector<TraceEvent>(CAPACITY);
+    uint64_t written = 0;  // total events recorded, including overwritten ones
+
+    void record(const char* name, uint64_t start, uint64_t duration) {
+        events[written % CAPACITY] = {name, start, duration};
+        written++;
+    }
+};
+
+// Owns every trace buffer. A thread that exits hands its buffer back for the next new thread,
+// so the per-iteration search threads reuse a handful of buffers instead of piling up new ones.
+class TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::vector<TraceBuffer*> unused;
+
+public:
+    TraceBuffer* acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!unused.empty()) {
+            TraceBuffer* buffer = unused.back();
+            unused.pop_back();
+            return buffer;
+        }
+        buffers.push_back(std::make_unique<TraceBuffer>());
+        buffers.back()->id = static_cast<int>(buffers.size());
+        return buffers.back().get();
+    }
+
+    void release(TraceBuffer* buffer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        unused.push_back(buffer);
+    }
+
+    // call fn on every buffer; no thread may be recording at the same time
+    template <typename Fn>
+    void forEach(Fn fn) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& buffer : buffers) {
+            fn(*buffer);
+        }
+    }
+
+    void clear() {
+        forEach([](TraceBuffer& buffer) { buffer.written = 0; });
+    }
+};
+
+inline TraceRegistry& traceRegistry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+inline TraceBuffer& threadTraceBuffer() {
+    struct Holder {
+        TraceBuffer* buffer = traceRegistry().acquire();
+        ~Holder() { traceRegistry().release(buffer); }
+    };
+    thread_local Holder holder;
+    return *holder.buffer;
+}
+
+inline uint64_t traceNow() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+// records the lifetime of the object as one event
+class TraceScope {
+    const char* name;
+    uint64_t start;
+
+public:
+    explicit TraceScope(const char* scopeName) : name(scopeName), start(traceNow()) {}
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    ~TraceScope() {
+        threadTraceBuffer().record(name, start, traceNow() - start);
+    }
+};
+
+// Write every recorded event as Chrome trace-event JSON. Call it when no search is running.
+// Returns false if the file could not be written.
+inline bool writeChromeTrace(const std::string& filename) {
+    FILE* file = std::fopen(filename.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    std::fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    bool first = true;
+    traceRegistry().forEach([&](const TraceBuffer& buffer) {
+        std::fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                           "\"args\":{\"name\":\"engine thread %d\"}}",
+                     first ? "" : ",", buffer.id, buffer.id);
+        first = false;
+        const uint64_t begin = buffer.written > TraceBuffer::CAPACITY ? buffer.written - TraceBuffer::CAPACITY : 0;
+        for (uint64_t i = begin; i < buffer.written; i++) {
+            const TraceEvent& event = buffer.events[i % TraceBuffer::CAPACITY];
+            std::fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                         event.name, buffer.id, event.start / 1000.0, event.duration / 1000.0);
+        }
+    });
+    std::fprintf(file, "\n]}\n");
+    return std::fclose(file) == 0;
+}
+
+#endif // ABALONE_TRACE_H
@@ -0,0 +1,249 @@
+#include "engine.h"
+#include "eval_weights.h"
+#include "gamerecord.h"
+
+#include <iostream>
+#include <cmath>
+
+/*
+ * Tune the evaluation weights on recorded games (Texel's method): every position of every
+ * finished game is labelled with the result, 1 if Black went on to win, 0 if White did and 0.5
+ * for a draw by repetition, and the weights are fitted so that sigmoid(K * evaluation) predicts
+ * the label. K is fitted to the starting weights first and then kept, so the tuned weights stay
+ * on the same scale. Features switched off in the starting weights (weight 0) stay off.
+ *
+ * The evaluation features are computed once per position into a feature matrix; the optimiser
+ * (Adam on the mean squared error) then only ever reads that matrix, split across threads.
+ *
+ * usage: tune [--threads n] [--iterations n] [--weights <start file>] [--output <file>] <record files...>
+ */
+
+// one row of features per position, stored contiguously, and the result of its game
+struct FeatureMatrix {
+    std::vector<int16_t> features;  // rows * EVAL_FEATURE_COUNT
+    std::vector<float> results;
+
+    [[nodiscard]] size_t rows() const {
+        return results.size();
+    }
+
+    void add(const std::array<int, EVAL_FEATURE_COUNT>& row, float result) {
+        for (const int value : row) {
+            features.push_back(static_cast<int16_t>(value));
+        }
+        results.push_back(result);
+    }
+};
+
+// run fn(begin, end) over the rows split into one slice per thread, and sum what the slices return
+template <typename Result, typename Fn>
+Result parallelSum(const FeatureMatrix& matrix, int threads, Fn fn) {
+    std::vector<Result> partial(threads);
+    std::vector<std::thread> workers;
+    const size_t slice = (matrix.rows() + threads - 1) / threads;
+    for (int thread = 0; thread < threads; thread++) {
+        const size_t begin = std::min(matrix.rows(), thread * slice);
+        const size_t end = std::min(matrix.rows(), begin + slice);
+        workers.emplace_back([&partial, &fn, thread, begin, end]() { partial[thread] = fn(begin, end); });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    Result sum = partial[0];
+    for (int thread = 1; thread < threads; thread++) {
+        sum += partial[thread];
+    }
+    return sum;
+}
+
+using Weights = std::array<double, EVAL_FEATURE_COUNT>;
+
+double sigmoid(double x) {
+    return 1.0 / (1.0 + std::exp(-x));
+}
+
+double evaluation(const int16_t* row, const Weights& weights) {
+    double score = 0;
+    for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+        score += weights[feature] * row[feature];
+    }
+    return score;
+}
+
+// mean squared error of the predictions
+double meanError(const FeatureMatrix& matrix, int threads, const Weights& weights, double k) {
+    const double sum = parallelSum<double>(matrix, threads, [&](size_t begin, size_t end) {
+        double error = 0;
+        for (size_t i = begin; i < end; i++) {
+            const double diff = matrix.results[i] - sigmoid(k * evaluation(&matrix.features[i * EVAL_FEATURE_COUNT], weights));
+            error += diff * diff;
+        }
+        return error;
+    });
+    return sum / static_cast<double>(matrix.rows());
+}
+
+// gradient of meanError with respect to the weights
+Weights gradient(const FeatureMatrix& matrix, int threads, const Weights& weights, double k) {
+    struct Sum {
+        Weights values{};
+        Sum& operator+=(const Sum& other) {
+            for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) values[feature] += other.values[feature];
+            return *this;
+        }
+    };
+    Sum sum = parallelSum<Sum>(matrix, threads, [&](size_t begin, size_t end) {
+        Sum slice;
+        for (size_t i = begin; i < end; i++) {
+            const int16_t* row = &matrix.features[i * EVAL_FEATURE_COUNT];
+            const double prediction = sigmoid(k * evaluation(row, weights));
+            const double factor = -2.0 * (matrix.results[i] - prediction) * prediction * (1.0 - prediction) * k;
+            for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+                slice.values[feature] += factor * row[feature];
+            }
+        }
+        return slice;
+    });
+    for (double& value : sum.values) {
+        value /= static_cast<double>(matrix.rows());
+    }
+    return sum.values;
+}
+
+// the scaling constant that fits the starting weights best (golden-section search on log K)
+double fitK(const FeatureMatrix& matrix, int threads, const Weights& weights) {
+    double low = std::log(1e-5);
+    double high = std::log(1.0);
+    const double ratio = (std::sqrt(5.0) - 1) / 2;
+    for (int step = 0; step < 40; step++) {
+        const double a = high - ratio * (high - low);
+        const double b = low + ratio * (high - low);
+        if (meanError(matrix, threads, weights, std::exp(a)) < meanError(matrix, threads, weights, std::exp(b))) {
+            high = b;
+        } else {
+            low = a;
+        }
+    }
+    return std::exp((low + high) / 2);
+}
+
+// label every position of every decided or drawn game in a record file
+void loadGames(const std::string& filename, FeatureMatrix& matrix, size_t& games) {
+    GameRecordFile records;
+    if (!records.open(filename)) {
+        std::cerr << "Warning: no game records in " << filename << std::endl;
+        return;
+    }
+    for (size_t index = 0; index < records.gameCount(); index++) {
+        const GameRecord& game = records.game(index);
+        const auto result = static_cast<GameResult>(game.info().result);
+        if (result == GameResult::NONE) {
+            continue;
+        }
+        const float label = (result == GameResult::BLACK_WINS) ? 1.0f : (result == GameResult::DRAW) ? 0.5f : 0.0f;
+        GameReplay replay(game);
+        for (uint32_t ply = 0; ply <= replay.plyCount(); ply++) {
+            replay.seek(ply);
+            matrix.add(evaluationFeatures<CellState::BLACK>(replay.position()), label);
+        }
+        games++;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    int iterations = 2000;
+    EvalWeights startWeights = evalWeights();
+    std::string outputFileName = "eval.weights";
+    std::vector<std::string> recordFiles;
+    for (int arg = 1; arg < argc; arg++) {
+        const std::string option = argv[arg];
+        if (option == "--threads" && arg + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++arg]));
+        } else if (option == "--iterations" && arg + 1 < argc) {
+            iterations = std::max(0, std::atoi(argv[++arg]));
+        } else if (option == "--weights" && arg + 1 < argc) {
+            if (!readEvalWeights(argv[++arg], startWeights)) {
+                return 1;
+            }
+        } else if (option == "--output" && arg + 1 < argc) {
+            outputFileName = argv[++arg];
+        } else {
+            recordFiles.push_back(option);
+        }
+    }
+    if (recordFiles.empty()) {
+        std::cerr << "usage: tune [--threads n] [--iterations n] [--weights <start file>] [--output <file>] "
+                     "<record files...>" << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    FeatureMatrix matrix;
+    size_t games = 0;
+    for (const std::string& filename : recordFiles) {
+        loadGames(filename, matrix, games);
+    }
+    if (matrix.rows() == 0) {
+        std::cerr << "Error: no finished games to tune on" << std::endl;
+        return 1;
+    }
+    std::cout << matrix.rows() << " positions from " << games << " games" << std::endl;
+
+    Weights weights;
+    for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+        weights[feature] = startWeights[feature];
+    }
+    const double k = fitK(matrix, threads, weights);
+    const double startError = meanError(matrix, threads, weights, k);
+    std::cout << "K " << k << ", error " << startError << std::endl;
+
+    // Adam, with steps of about one weight unit to begin with
+    const double learningRate = 1.0;
+    const double beta1 = 0.9;
+    const double beta2 = 0.999;
+    Weights moment{};
+    Weights velocity{};
+    for (int iteration = 1; iteration <= iterations; iteration++) {
+        const Weights grad = gradient(matrix, threads, weights, k);
+        for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+            if (startWeights[feature] == 0) {
+                continue;
+            }
+            moment[feature] = beta1 * moment[feature] + (1 - beta1) * grad[feature];
+            velocity[feature] = beta2 * velocity[feature] + (1 - beta2) * grad[feature] * grad[feature];
+            const double momentHat = moment[feature] / (1 - std::pow(beta1, iteration));
+            const double velocityHat = velocity[feature] / (1 - std::pow(beta2, iteration));
+            weights[feature] -= learningRate * momentHat / (std::sqrt(velocityHat) + 1e-12);
+        }
+        if (iteration % 200 == 0) {
+            std::cout << "Iteration " << iteration << ", error " << meanError(matrix, threads, weights, k) << std::endl;
+        }
+    }
+
+    // the engine's weights are integers
+    EvalWeights tuned;
+    Weights rounded;
+    for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+        tuned[feature] = static_cast<int>(std::lround(weights[feature]));
+        rounded[feature] = tuned[feature];
+    }
+    const double tunedError = meanError(matrix, threads, rounded, k);
+
+    std::ostringstream comment;
+    comment << "tuned on " << matrix.rows() << " positions from " << games << " games, K " << k << "\n"
+            << "error " << startError << " with the starting weights, " << tunedError << " with these";
+    if (!writeEvalWeights(outputFileName, tuned, comment.str())) {
+        std::cerr << "Error: Could not write " << outputFileName << std::endl;
+        return 1;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    std::cout << "Error " << startError << " -> " << tunedError << ", wrote " << outputFileName << " in "
+              << duration.count() << " ms" << std::endl;
+    for (int feature = 0; feature < EVAL_FEATURE_COUNT; feature++) {
+        std::cout << "  " << EVAL_FEATURE_NAMES[feature] << " " << startWeights[feature] << " -> " << tuned[feature]
+                  << std::endl;
+    }
+    return 0;
+}